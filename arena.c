@@ -0,0 +1,103 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "eurysta.h"
+
+// every allocation is aligned to this
+#define ARENA_ALIGN 8
+
+static struct cs_arena_chunk *chunk_create_(size_t size) {
+    struct cs_arena_chunk *c = malloc(sizeof(struct cs_arena_chunk) + size);
+    if (c == NULL)
+        return NULL;
+    c->next = NULL;
+    c->size = size;
+    c->used = 0;
+    return c;
+}
+
+cs_arena *cs_arena_create(size_t chunk_size) {
+    cs_arena *a = malloc(sizeof(cs_arena));
+    if (a == NULL)
+        return NULL;
+
+    a->chunk_size = (chunk_size > 0) ? chunk_size : 4096;
+    if ((a->head = chunk_create_(a->chunk_size)) == NULL) {
+        free(a);
+        return NULL;
+    }
+    a->current = a->head;
+
+    return a;
+}
+
+void *cs_arena_alloc(cs_arena *a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    // move on through the chunks kept from before the last reset, then grow
+    struct cs_arena_chunk *c = a->current;
+    while (c->size - c->used < size) {
+        if (c->next == NULL) {
+            struct cs_arena_chunk *n = chunk_create_((size > a->chunk_size) ? size : a->chunk_size);
+            if (n == NULL)
+                return NULL;
+            c->next = n;
+        }
+        c = c->next;
+    }
+    a->current = c;
+
+    void *v = c->data + c->used;
+    c->used += size;
+    return v;
+}
+
+char *cs_arena_strdup(cs_arena *a, const char *s) {
+    size_t len = strlen(s) + 1;
+    char *d = cs_arena_alloc(a, len);
+    if (d != NULL)
+        memcpy(d, s, len);
+    return d;
+}
+
+void cs_arena_reset(cs_arena *a) {
+    for (struct cs_arena_chunk *c = a->head; c != NULL; c = c->next)
+        c->used = 0;
+    a->current = a->head;
+}
+
+void cs_arena_destroy(cs_arena *a) {
+    struct cs_arena_chunk *c = a->head;
+    while (c != NULL) {
+        struct cs_arena_chunk *n = c->next;
+        free(c);
+        c = n;
+    }
+    free(a);
+}
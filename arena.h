@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_ARENA_H
+#define CS_ARENA_H
+
+#include <stddef.h>
+
+// A bump allocator for short-lived bytes, typically the strings of a document being built
+//  (pair it with cs_string_create(..., CS_STR_BORROW)). Nothing is freed individually;
+//  cs_arena_reset makes all of it reusable at once and keeps the chunks for next time.
+
+struct cs_arena_chunk {
+    struct cs_arena_chunk *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+struct cs_arena {
+    struct cs_arena_chunk *head;
+    struct cs_arena_chunk *current;
+    size_t chunk_size;
+};
+
+typedef struct cs_arena cs_arena;
+
+cs_arena *cs_arena_create(size_t chunk_size);
+
+void *cs_arena_alloc(cs_arena *a, size_t size);
+
+char *cs_arena_strdup(cs_arena *a, const char *s);
+
+// everything allocated so far becomes invalid; the memory itself is kept
+void cs_arena_reset(cs_arena *a);
+
+void cs_arena_destroy(cs_arena *a);
+
+#endif
@@ -0,0 +1,152 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// sysconf(_SC_NPROCESSORS_ONLN) is not C99
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <pthread.h>
+#include <unistd.h>
+#include "eurysta.h"
+
+// documents are handed out to workers this many at a time
+#define BATCH_CHUNK 64
+
+struct batch_job_ {
+    const cs_json_buf *docs;
+    cs_json_result *results;
+    size_t count;
+    size_t next;        // next unclaimed document, advanced atomically
+    size_t succeeded;   // likewise
+};
+
+static void *batch_worker_(void *arg) {
+    struct batch_job_ *job = arg;
+    // the one and only parser context this worker needs
+    cs_json_parser p;
+    size_t ok = 0;
+
+    for (;;) {
+        size_t start = __sync_fetch_and_add(&job->next, BATCH_CHUNK);
+        if (start >= job->count)
+            break;
+        size_t end = (start + BATCH_CHUNK < job->count) ? start + BATCH_CHUNK : job->count;
+
+        for (size_t i = start; i < end; i++) {
+            cs_json_result *r = &job->results[i];
+            if (!cs_parser_init_sn(&p, job->docs[i].data, job->docs[i].len)) {
+                r->root = NULL;
+                r->error = ERR_ILLEGAL;
+                r->position = job->docs[i].len;
+                continue;
+            }
+            r->root = cs_json_parse(&p);
+            r->error = p.error;
+            r->position = p.position;
+            ok += (r->root != NULL);
+        }
+    }
+
+    __sync_fetch_and_add(&job->succeeded, ok);
+    return NULL;
+}
+
+// Helper threads are started the first time a batch needs them and then wait for the next
+//  one, so a call doesn't pay for creating threads. One batch is shared out at a time.
+static pthread_mutex_t pool_lock_ = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work_ = PTHREAD_COND_INITIALIZER;   // a batch has open slots
+static pthread_cond_t pool_idle_ = PTHREAD_COND_INITIALIZER;   // helpers done, or pool free
+static struct batch_job_ *pool_job_;    // the batch being worked on, NULL when none is
+static uint32_t pool_open_;             // helpers the batch can still take on
+static uint32_t pool_busy_;             // helpers working on it
+static uint32_t pool_size_;             // helpers started
+
+static void *pool_helper_(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&pool_lock_);
+    for (;;) {
+        while (pool_open_ == 0)
+            pthread_cond_wait(&pool_work_, &pool_lock_);
+        pool_open_--;
+        pool_busy_++;
+        struct batch_job_ *job = pool_job_;
+        pthread_mutex_unlock(&pool_lock_);
+
+        batch_worker_(job);
+
+        pthread_mutex_lock(&pool_lock_);
+        if (--pool_busy_ == 0)
+            pthread_cond_broadcast(&pool_idle_);
+    }
+    return NULL;
+}
+
+size_t cs_json_parse_batch(const cs_json_buf *docs, size_t count, cs_json_result *results, uint32_t threads) {
+    struct batch_job_ job = { docs, results, count, 0, 0 };
+
+    // no point in more threads than there are chunks, or CPUs to run them
+    size_t chunks = (count + BATCH_CHUNK - 1) / BATCH_CHUNK;
+    if (threads > chunks)
+        threads = (uint32_t)chunks;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0 && threads > (unsigned long)cpus)
+        threads = (uint32_t)cpus;
+
+    if (threads <= 1) {
+        batch_worker_(&job);
+        return job.succeeded;
+    }
+
+    pthread_mutex_lock(&pool_lock_);
+    while (pool_job_ != NULL)
+        pthread_cond_wait(&pool_idle_, &pool_lock_);
+    // the calling thread works too, so one fewer helper
+    for (; pool_size_ < threads - 1; pool_size_++) {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, pool_helper_, NULL) != 0)
+            break;
+        pthread_detach(tid);
+    }
+    pool_job_ = &job;
+    pool_open_ = (pool_size_ < threads - 1) ? pool_size_ : threads - 1;
+    pthread_cond_broadcast(&pool_work_);
+    pthread_mutex_unlock(&pool_lock_);
+
+    batch_worker_(&job);
+
+    // every chunk has been claimed: helpers that haven't started by now aren't needed
+    pthread_mutex_lock(&pool_lock_);
+    pool_open_ = 0;
+    while (pool_busy_ > 0)
+        pthread_cond_wait(&pool_idle_, &pool_lock_);
+    pool_job_ = NULL;
+    pthread_cond_broadcast(&pool_idle_);
+    pthread_mutex_unlock(&pool_lock_);
+
+    return job.succeeded;
+}
@@ -0,0 +1,55 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_BATCH_H
+#define CS_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// one input document: len bytes at data, followed by a '\0' (as for cs_parser_create_sn)
+struct cs_json_buf {
+    const char *data;
+    size_t len;
+};
+
+struct cs_json_result {
+    cs_json_obj *root;  // NULL on error; otherwise owned by the caller (cs_object_destroy)
+    err_t error;
+    uint64_t position;  // where the parser stopped, e.g. the offset of the error
+};
+
+typedef struct cs_json_buf cs_json_buf;
+typedef struct cs_json_result cs_json_result;
+
+// parses docs[0..count) into results[0..count), reusing a single parser context per worker;
+// with threads > 1 the documents are shared out between that many threads (at most one per
+// online CPU): the caller and helpers that are started on first use and kept for later calls.
+// returns the number of documents that parsed successfully
+size_t cs_json_parse_batch(const cs_json_buf *docs, size_t count, cs_json_result *results, uint32_t threads);
+
+#endif
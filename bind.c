@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
+#include "eurysta.h"
+
+// the member size each type binds into; 0 when any non-zero size will do
+static size_t type_size_(enum bind_type t) {
+    switch (t) {
+        case BIND_STRING: return sizeof(char *);
+        case BIND_DOUBLE: return sizeof(double);
+        case BIND_INT:    return sizeof(int64_t);
+        case BIND_BOOL:   return sizeof(uint8_t);
+        default:          return 0;
+    }
+}
+
+uint8_t cs_bind_init(cs_bind_desc *d) {
+    if (d == NULL)
+        return 0;
+    if (d->ready)
+        return 1;
+
+    for (uint32_t i = 0; i < d->count; i++) {
+        cs_bind_field *f = &d->fields[i];
+        size_t size = type_size_(f->type);
+        // a value would be stored past the member
+        if (f->size == 0 || (size != 0 && f->size != size))
+            return 0;
+        if (f->type == BIND_OBJECT && !cs_bind_init((cs_bind_desc *)f->nested))
+            return 0;
+        f->name_len = strlen(f->name);
+        f->hash = cs_bind_hash(f->name, f->name_len);
+    }
+    d->ready = 1;
+    return 1;
+}
+
+void cs_bind_clear(const cs_bind_desc *d, char *out) {
+    for (uint32_t i = 0; i < d->count; i++) {
+        const cs_bind_field *f = &d->fields[i];
+        if (f->type == BIND_STRING)
+            *(char **)(out + f->offset) = NULL;
+        else if (f->type == BIND_OBJECT)
+            cs_bind_clear(f->nested, out + f->offset);
+    }
+}
+
+const cs_bind_field *cs_bind_find(const cs_bind_desc *d, const char *key, size_t len) {
+    uint32_t h = cs_bind_hash(key, len);
+    for (uint32_t i = 0; i < d->count; i++) {
+        const cs_bind_field *f = &d->fields[i];
+        if (f->hash == h && f->name_len == len && memcmp(f->name, key, len) == 0)
+            return f;
+    }
+    return NULL;
+}
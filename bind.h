@@ -0,0 +1,96 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_BIND_H
+#define CS_BIND_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Schema-driven binding: fills a caller's struct straight from the token stream,
+//  without ever building cs_json_obj/cs_hash_tab nodes. Unknown keys are skipped,
+//  JSON null and absent keys leave the member untouched -- except BIND_STRING members,
+//  which every bind starts by setting to NULL.
+
+enum bind_type {
+    BIND_STRING,    // char *, malloc'd -- the caller frees it
+    BIND_CHARS,     // char[size], truncated and always NUL-terminated
+    BIND_DOUBLE,    // double
+    BIND_INT,       // int64_t, from a number with an integral value (1e3, not 1.5)
+    BIND_BOOL,      // uint8_t
+    BIND_OBJECT     // nested struct described by another cs_bind_desc
+};
+
+struct cs_bind_desc;
+
+struct cs_bind_field {
+    const char *name;
+    enum bind_type type;
+    size_t offset;
+    size_t size;
+    const struct cs_bind_desc *nested;
+    // filled in by cs_bind_init
+    uint32_t hash;
+    uint32_t name_len;
+};
+
+struct cs_bind_desc {
+    struct cs_bind_field *fields;
+    uint32_t count;
+    uint8_t ready;
+};
+
+typedef struct cs_bind_field cs_bind_field;
+typedef struct cs_bind_desc cs_bind_desc;
+
+// field descriptors for member m of struct s, named after the member itself
+#define CS_BIND(s, m, t) { #m, (t), offsetof(s, m), sizeof(((s *)0)->m), NULL, 0, 0 }
+#define CS_BIND_OBJ(s, m, d) { #m, BIND_OBJECT, offsetof(s, m), sizeof(((s *)0)->m), (d), 0, 0 }
+#define CS_BIND_DESC(fields) { (fields), sizeof(fields) / sizeof((fields)[0]), 0 }
+
+// FNV-1a, used to match keys against descriptor names
+static inline uint32_t cs_bind_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    while (len--) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// precomputes key hashes for d and every descriptor nested in it; call once, before binding.
+//  returns 0 if a field's size doesn't fit its type (e.g. BIND_INT on an int member); a
+//  descriptor that failed can't be bound with
+uint8_t cs_bind_init(cs_bind_desc *d);
+
+// finds the field called key (len bytes), or NULL
+const cs_bind_field *cs_bind_find(const cs_bind_desc *d, const char *key, size_t len);
+
+// used by parser.c: sets the BIND_STRING members of out, nested ones too, to NULL
+void cs_bind_clear(const cs_bind_desc *d, char *out);
+
+#endif
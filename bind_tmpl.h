@@ -0,0 +1,162 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Token-level half of the binding API (see bind.h); instantiated by parser.c right after
+//  parser_tmpl.h, whose lexer it shares. There are deliberately no include guards.
+
+static uint8_t TMPL_(bind_object_)(cs_json_parser *, const cs_bind_desc *, char *);
+
+static uint8_t TMPL_(bind_field_)(cs_json_parser *p, const cs_bind_field *f, char *dst) {
+    char buffer[256];
+    size_t len = 0;
+    tok_t t = TMPL_(get_tok_)(p);
+
+    switch (t) {
+        // null binds as "not there"
+        case TOK_NULL:
+            return 1;
+
+        case TOK_TRUE: case TOK_FALSE:
+            if (f->type != BIND_BOOL)
+                break;
+            *(uint8_t *)dst = (t == TOK_TRUE);
+            return 1;
+
+        case TOK_NUMBER:
+            if (f->type != BIND_DOUBLE && f->type != BIND_INT)
+                break;
+            if (TMPL_(number_text_)(p, buffer, sizeof(buffer)) == 0)
+                return 0;
+            if (f->type == BIND_DOUBLE)
+                *(double *)dst = strtod(buffer, NULL);
+            else if (!int_value_(buffer, (int64_t *)dst))
+                break;
+            return 1;
+
+        case TOK_STRING:
+            if (f->type == BIND_STRING) {
+                char *s = TMPL_(string_)(p, &len);
+                if (s == NULL)
+                    return 0;
+                // the key may come up more than once, the last value wins; the member was
+                //  cleared when the bind started, so anything in it was stored by this one
+                free(*(char **)dst);
+                *(char **)dst = s;
+                return 1;
+            }
+            else if (f->type == BIND_CHARS && f->size > 0) {
+                char *s = TMPL_(decode_)(p, buffer, sizeof(buffer), &len);
+                if (s == NULL)
+                    return 0;
+                if (len > f->size - 1)
+                    len = f->size - 1;
+                memcpy(dst, s, len);
+                dst[len] = '\0';
+                if (s != buffer)
+                    free(s);
+                return 1;
+            }
+            break;
+
+        case TOK_LCURLY:
+            if (f->type != BIND_OBJECT)
+                break;
+            return TMPL_(bind_object_)(p, f->nested, dst);
+
+        case TOK_LSQUARE:
+            break;
+
+        default:
+            if (p->error == ERR_NONE)
+                p->error = ERR_EXPECTED_VALUE;
+            return 0;
+    }
+
+    p->error = ERR_TYPE_MISMATCH;
+    return 0;
+}
+
+static uint8_t TMPL_(bind_members_)(cs_json_parser *p, const cs_bind_desc *d, char *out) {
+    char buffer[256];
+    size_t len = 0;
+
+    do {
+        if (TMPL_(get_tok_)(p) != TOK_STRING) {
+            if (p->current == TOK_RCURLY)
+                return 1;
+            if (p->error == ERR_NONE)
+                p->error = ERR_EXPECTED_KEY;
+            return 0;
+        }
+
+        // keys are decoded on the stack; a key too long for it can't be one of ours anyway
+        char *key = TMPL_(decode_)(p, buffer, sizeof(buffer), &len);
+        if (key == NULL)
+            return 0;
+        const cs_bind_field *f = cs_bind_find(d, key, len);
+        if (key != buffer)
+            free(key);
+
+        if (TMPL_(get_tok_)(p) != TOK_COLON) {
+            p->error = ERR_EXPECTED_COLON;
+            return 0;
+        }
+
+        if (f == NULL) {
+            if (!TMPL_(skip_value_)(p, TMPL_(get_tok_)(p)))
+                return 0;
+        }
+        else if (!TMPL_(bind_field_)(p, f, out + f->offset)) {
+            return 0;
+        }
+
+    } while (TMPL_(get_tok_)(p) == TOK_COMMA);
+
+    if (p->current == TOK_RCURLY)
+        return 1;
+
+    p->error = ERR_EXPECTED_RCURLY;
+    return 0;
+}
+
+// the opening { has been consumed
+static uint8_t TMPL_(bind_object_)(cs_json_parser *p, const cs_bind_desc *d, char *out) {
+    if (!nest_(p))
+        return 0;
+    uint8_t ok = TMPL_(bind_members_)(p, d, out);
+    p->depth--;
+    return ok;
+}
+
+static uint8_t TMPL_(bind_)(cs_json_parser *p, const cs_bind_desc *d, void *out) {
+    if (TMPL_(get_tok_)(p) != TOK_LCURLY) {
+        if (p->error == ERR_NONE)
+            p->error = ERR_TYPE_MISMATCH;
+        return 0;
+    }
+    return TMPL_(bind_object_)(p, d, (char *)out);
+}
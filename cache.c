@@ -0,0 +1,245 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "eurysta.h"
+
+struct cs_cache_entry {
+    uint64_t hash;
+    char *input;            // our copy of the bytes the tree was parsed from
+    size_t len;
+    cs_json_obj *root;
+    cs_json_obj null_root;  // the root of a null document, which can't be the shared null
+    size_t refs;            // trees handed out and not yet released
+    uint8_t cached;         // still findable by input (not evicted)
+    struct cs_cache_entry *next_input, *next_root;
+    struct cs_cache_entry *newer, *older;
+};
+
+static inline size_t root_bucket_(cs_json_cache *c, cs_json_obj *root) {
+    return (size_t)((((uint64_t)(uintptr_t)root >> 4) * 0x9e3779b97f4a7c15ULL) >> 32) & (c->buckets - 1);
+}
+
+static void entry_free_(struct cs_cache_entry *e) {
+    cs_object_destroy_frozen(e->root);
+    free(e->input);
+    free(e);
+}
+
+static struct cs_cache_entry *find_(cs_json_cache *c, uint64_t hash, const char *data, size_t len) {
+    struct cs_cache_entry *e = c->by_input[hash & (c->buckets - 1)];
+    for (; e != NULL; e = e->next_input) {
+        if (e->hash == hash && e->len == len && memcmp(e->input, data, len) == 0)
+            return e;
+    }
+    return NULL;
+}
+
+static void lru_unlink_(cs_json_cache *c, struct cs_cache_entry *e) {
+    if (e->newer != NULL)
+        e->newer->older = e->older;
+    else
+        c->newest = e->older;
+    if (e->older != NULL)
+        e->older->newer = e->newer;
+    else
+        c->oldest = e->newer;
+}
+
+static void lru_push_(cs_json_cache *c, struct cs_cache_entry *e) {
+    e->newer = NULL;
+    e->older = c->newest;
+    if (c->newest != NULL)
+        c->newest->newer = e;
+    else
+        c->oldest = e;
+    c->newest = e;
+}
+
+static void unlink_root_(cs_json_cache *c, struct cs_cache_entry *e) {
+    struct cs_cache_entry **pp = &c->by_root[root_bucket_(c, e->root)];
+    while (*pp != e)
+        pp = &(*pp)->next_root;
+    *pp = e->next_root;
+}
+
+// drops the least recently used document; whoever still holds it keeps it until release
+static void evict_(cs_json_cache *c) {
+    struct cs_cache_entry *e = c->oldest;
+    lru_unlink_(c, e);
+
+    struct cs_cache_entry **pp = &c->by_input[e->hash & (c->buckets - 1)];
+    while (*pp != e)
+        pp = &(*pp)->next_input;
+    *pp = e->next_input;
+
+    e->cached = 0;
+    c->count--;
+    if (e->refs == 0) {
+        unlink_root_(c, e);
+        entry_free_(e);
+    }
+}
+
+cs_json_cache *cs_cache_create(size_t capacity, uint32_t options) {
+    cs_json_cache *c = calloc(1, sizeof(cs_json_cache));
+    if (c == NULL)
+        return NULL;
+
+    // chains stay short at up to twice as many entries as buckets (held, evicted ones included)
+    c->buckets = 16;
+    while (c->buckets < capacity)
+        c->buckets *= 2;
+    c->by_input = calloc(c->buckets, sizeof(struct cs_cache_entry *));
+    c->by_root = calloc(c->buckets, sizeof(struct cs_cache_entry *));
+    if (c->by_input == NULL || c->by_root == NULL || pthread_mutex_init(&c->lock, NULL) != 0) {
+        free(c->by_input);
+        free(c->by_root);
+        free(c);
+        return NULL;
+    }
+    c->capacity = capacity;
+    c->options = options;
+    return c;
+}
+
+cs_json_obj *cs_cache_parse(cs_json_cache *c, const char *data, size_t len, err_t *error) {
+    uint64_t hash = cs_json_hash_bytes(data, len);
+
+    pthread_mutex_lock(&c->lock);
+    struct cs_cache_entry *e = find_(c, hash, data, len);
+    if (e != NULL) {
+        e->refs++;
+        lru_unlink_(c, e);
+        lru_push_(c, e);
+        c->hits++;
+        pthread_mutex_unlock(&c->lock);
+        if (error != NULL)
+            *error = ERR_NONE;
+        return e->root;
+    }
+    c->misses++;
+    pthread_mutex_unlock(&c->lock);
+
+    // parse outside the lock; the copy also gives the parser its terminating NUL
+    e = malloc(sizeof(struct cs_cache_entry));
+    char *input = malloc(len + 1);
+    if (e == NULL || input == NULL) {
+        free(e);
+        free(input);
+        if (error != NULL)
+            *error = ERR_NO_MEM;
+        return NULL;
+    }
+    memcpy(input, data, len);
+    input[len] = '\0';
+
+    cs_json_parser p;
+    cs_parser_init_sn(&p, input, len);
+    p.options = c->options;
+    cs_json_obj *root = cs_json_parse(&p);
+    if (error != NULL)
+        *error = p.error;
+    if (root == NULL) {
+        free(e);
+        free(input);
+        return NULL;
+    }
+    // every null document parses to the same node, but release tells documents apart by root
+    if (root->type == OBJ_TYPE_NULL) {
+        e->null_root.type = OBJ_TYPE_NULL;
+        e->null_root.flags = 0;
+        e->null_root.data = NULL;
+        root = &e->null_root;
+    }
+    // shared from here on
+    cs_object_freeze(root);
+
+    e->hash = hash;
+    e->input = input;
+    e->len = len;
+    e->root = root;
+    e->refs = 1;
+
+    pthread_mutex_lock(&c->lock);
+    // another thread may have parsed the same bytes in the meantime: use its tree
+    struct cs_cache_entry *other = find_(c, hash, data, len);
+    if (other != NULL) {
+        other->refs++;
+        pthread_mutex_unlock(&c->lock);
+        entry_free_(e);
+        return other->root;
+    }
+
+    size_t b = hash & (c->buckets - 1);
+    e->next_input = c->by_input[b];
+    c->by_input[b] = e;
+    b = root_bucket_(c, root);
+    e->next_root = c->by_root[b];
+    c->by_root[b] = e;
+    e->cached = 1;
+    lru_push_(c, e);
+    if (++c->count > c->capacity)
+        evict_(c);
+    pthread_mutex_unlock(&c->lock);
+
+    return root;
+}
+
+void cs_cache_release(cs_json_cache *c, cs_json_obj *root) {
+    if (root == NULL)
+        return;
+
+    pthread_mutex_lock(&c->lock);
+    struct cs_cache_entry *e = c->by_root[root_bucket_(c, root)];
+    while (e != NULL && e->root != root)
+        e = e->next_root;
+    if (e != NULL && --e->refs == 0 && !e->cached) {
+        unlink_root_(c, e);
+        entry_free_(e);
+    }
+    pthread_mutex_unlock(&c->lock);
+}
+
+void cs_cache_stats(cs_json_cache *c, size_t *hits, size_t *misses) {
+    pthread_mutex_lock(&c->lock);
+    if (hits != NULL)
+        *hits = c->hits;
+    if (misses != NULL)
+        *misses = c->misses;
+    pthread_mutex_unlock(&c->lock);
+}
+
+void cs_cache_destroy(cs_json_cache *c) {
+    while (c->oldest != NULL)
+        evict_(c);
+    free(c->by_input);
+    free(c->by_root);
+    pthread_mutex_destroy(&c->lock);
+    free(c);
+}
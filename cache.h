@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_CACHE_H
+#define CS_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// A bounded LRU cache of parsed documents, keyed on the input bytes. Parsing a payload that
+//  is byte-for-byte one already in the cache hands back the same tree, shared, instead of
+//  parsing it again. Shared trees are frozen (cs_object_freeze); every tree obtained from
+//  cs_cache_parse must be given back with cs_cache_release, and stays valid until then
+//  even if it is evicted.
+// Safe to use from several threads at once.
+
+struct cs_cache_entry;
+
+struct cs_json_cache {
+    pthread_mutex_t lock;
+    struct cs_cache_entry **by_input;   // cached entries, by hash of the input bytes
+    struct cs_cache_entry **by_root;    // every entry still in use, by tree
+    size_t buckets;                     // of each table, a power of 2
+    struct cs_cache_entry *newest, *oldest;
+    size_t count, capacity;
+    uint32_t options;                   // cs_json_parser.options used for every parse
+    size_t hits, misses;
+};
+
+typedef struct cs_json_cache cs_json_cache;
+
+// capacity is the number of documents kept; options are the parser options (CS_PARSE_*),
+//  and the cache keeps its own copy of each input, so borrowed text stays valid
+cs_json_cache *cs_cache_create(size_t capacity, uint32_t options);
+
+// the tree for len bytes at data (which need not be NUL-terminated), from the cache or freshly
+//  parsed; NULL on a parse error, with *error (if not NULL) set
+cs_json_obj *cs_cache_parse(cs_json_cache *c, const char *data, size_t len, err_t *error);
+
+void cs_cache_release(cs_json_cache *c, cs_json_obj *root);
+
+void cs_cache_stats(cs_json_cache *c, size_t *hits, size_t *misses);
+
+// every tree handed out must have been released
+void cs_cache_destroy(cs_json_cache *c);
+
+#endif
@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <sched.h>
+#include "eurysta.h"
+
+cs_json_doc *cs_doc_create(cs_json_obj *root) {
+    cs_json_doc *d = malloc(sizeof(cs_json_doc));
+    if (d == NULL)
+        return NULL;
+
+    cs_object_freeze(root);
+    d->root = root;
+    d->refs = 1;
+    return d;
+}
+
+cs_json_doc *cs_doc_retain(cs_json_doc *d) {
+    if (d != NULL)
+        __atomic_add_fetch(&d->refs, 1, __ATOMIC_RELAXED);
+    return d;
+}
+
+void cs_doc_release(cs_json_doc *d) {
+    if (d == NULL)
+        return;
+    // every reader's last access happens before the count reaches zero
+    if (__atomic_sub_fetch(&d->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        cs_object_destroy_frozen(d->root);
+        free(d);
+    }
+}
+
+cs_json_obj *cs_doc_root(cs_json_doc *d) {
+    return d->root;
+}
+
+uint8_t cs_doc_slot_init(cs_doc_slot *s, cs_json_doc *d) {
+    s->current = d;
+    s->epoch = 0;
+    s->readers[0] = s->readers[1] = 0;
+    return pthread_mutex_init(&s->publish, NULL) == 0;
+}
+
+cs_json_doc *cs_doc_acquire(cs_doc_slot *s) {
+    for (;;) {
+        uint32_t e = __atomic_load_n(&s->epoch, __ATOMIC_SEQ_CST) & 1;
+        __atomic_add_fetch(&s->readers[e], 1, __ATOMIC_SEQ_CST);
+        // a publisher flipped the epoch in between and may not wait for this counter
+        if ((__atomic_load_n(&s->epoch, __ATOMIC_SEQ_CST) & 1) != e) {
+            __atomic_sub_fetch(&s->readers[e], 1, __ATOMIC_SEQ_CST);
+            continue;
+        }
+
+        cs_json_doc *d = cs_doc_retain(__atomic_load_n(&s->current, __ATOMIC_SEQ_CST));
+        __atomic_sub_fetch(&s->readers[e], 1, __ATOMIC_RELEASE);
+        return d;
+    }
+}
+
+void cs_doc_publish(cs_doc_slot *s, cs_json_doc *d) {
+    pthread_mutex_lock(&s->publish);
+    cs_json_doc *old = __atomic_exchange_n(&s->current, d, __ATOMIC_SEQ_CST);
+
+    // readers arriving from now on count on the other counter, so this only waits for the
+    //  few that may have loaded the old pointer and not yet retained it
+    uint32_t e = __atomic_fetch_xor(&s->epoch, 1, __ATOMIC_SEQ_CST) & 1;
+    while (__atomic_load_n(&s->readers[e], __ATOMIC_ACQUIRE) != 0)
+        sched_yield();
+    pthread_mutex_unlock(&s->publish);
+
+    cs_doc_release(old);
+}
+
+void cs_doc_slot_destroy(cs_doc_slot *s) {
+    cs_doc_release(s->current);
+    s->current = NULL;
+    pthread_mutex_destroy(&s->publish);
+}
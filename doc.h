@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_DOC_H
+#define CS_DOC_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+// A parsed tree shared, read-only, between threads. cs_doc_create freezes the tree (see
+//  cs_object_freeze) and puts a reference count on the document as a whole: readers retain
+//  and release the document, never individual nodes, and the tree is destroyed with the
+//  last reference.
+struct cs_json_doc {
+    cs_json_obj *root;
+    uint32_t refs;          // atomic
+};
+
+typedef struct cs_json_doc cs_json_doc;
+
+// takes root over and freezes it; the caller holds the one reference.
+//  NULL if out of memory, in which case root is left alone
+cs_json_doc *cs_doc_create(cs_json_obj *root);
+
+cs_json_doc *cs_doc_retain(cs_json_doc *d);
+
+void cs_doc_release(cs_json_doc *d);
+
+cs_json_obj *cs_doc_root(cs_json_doc *d);
+
+// The current version of a document, RCU style: readers pick up a reference without ever
+//  blocking, a writer publishes a replacement and drops the old version's reference once
+//  no reader can still be in the middle of picking it up.
+struct cs_doc_slot {
+    cs_json_doc *current;   // atomic
+    uint32_t epoch;         // atomic; selects the readers counter new readers use
+    uint32_t readers[2];    // atomic; readers between loading current and retaining it
+    pthread_mutex_t publish;
+};
+
+typedef struct cs_doc_slot cs_doc_slot;
+
+// takes over the reference to d (which may be NULL)
+uint8_t cs_doc_slot_init(cs_doc_slot *s, cs_json_doc *d);
+
+// the current version, retained (release it with cs_doc_release); NULL if none was published
+cs_json_doc *cs_doc_acquire(cs_doc_slot *s);
+
+// makes d (whose reference the slot takes over) the current version; readers that already
+//  hold the previous one keep it until they release it
+void cs_doc_publish(cs_doc_slot *s, cs_json_doc *d);
+
+// drops the slot's reference to the current version
+void cs_doc_slot_destroy(cs_doc_slot *s);
+
+#endif
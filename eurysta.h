@@ -30,6 +30,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "object.h"
 #include "parser.h"
+#include "bind.h"
+#include "batch.h"
+#include "cache.h"
+#include "doc.h"
+#include "validate.h"
+#include "pool.h"
+#include "arena.h"
+#include "writer.h"
+#include "project.h"
+#include "patch.h"
+#include "source.h"
 #include "c_data_structs/cs_hash_tab.h"
 #include "c_data_structs/cs_linked_list.h"
 
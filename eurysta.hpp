@@ -0,0 +1,318 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef EURYSTA_HPP
+#define EURYSTA_HPP
+
+// A thin, header-only C++17 layer over eurysta.h: owning handles with move semantics,
+//  std::string_view access to strings, range-for over arrays and objects, and member lookup
+//  by key.
+// Everything is inline and holds nothing but the C pointers it wraps.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+extern "C" {
+#include "eurysta.h"
+}
+
+namespace cs {
+
+// a NUL-terminated member name with its length, computed at compile time for literals:
+//  constexpr cs::key id("id");
+// lookups still hash the name at run time: cs_hash_tab uses its own hash function
+struct key {
+    const char *str;
+    size_t len;
+
+    // a char array needn't be filled up, so the length is that of the string it holds
+    template <size_t N>
+    constexpr key(const char (&s)[N]) : str(s), len(std::char_traits<char>::length(s)) {}
+
+    constexpr key(const char *s, size_t n) : str(s), len(n) {}
+};
+
+class value;
+
+// a non-owning view of a node; a value that isn't there (a missing member, an index out of
+//  range, a lookup on a non-container) is empty and answers every query with a default
+class value {
+public:
+    constexpr value(cs_json_obj *o = nullptr) noexcept : o_(o) {}
+
+    cs_json_obj *get() const noexcept { return o_; }
+    explicit operator bool() const noexcept { return o_ != nullptr; }
+
+    enum obj_type type() const noexcept { return o_ ? o_->type : OBJ_TYPE_NULL; }
+    bool is_object() const noexcept { return o_ && o_->type == OBJ_TYPE_OBJECT; }
+    bool is_array() const noexcept { return o_ && o_->type == OBJ_TYPE_ARRAY; }
+    bool is_string() const noexcept { return o_ && o_->type == OBJ_TYPE_STRING; }
+    bool is_number() const noexcept { return o_ && o_->type == OBJ_TYPE_NUMBER; }
+    bool is_bool() const noexcept { return o_ && o_->type == OBJ_TYPE_BOOL; }
+    bool is_null() const noexcept { return o_ && o_->type == OBJ_TYPE_NULL; }
+
+    // the string's bytes, in place; empty for anything else
+    std::string_view str() const noexcept {
+        return is_string() ? std::string_view(static_cast<const char *>(o_->data)) : std::string_view();
+    }
+    double num(double fallback = 0) const noexcept {
+        uint8_t ok = 0;
+        double v = cs_number_get_val(o_, &ok);
+        return ok ? v : fallback;
+    }
+    int64_t integer(int64_t fallback = 0) const noexcept {
+        uint8_t ok = 0;
+        int64_t v = cs_number_get_int(o_, &ok);
+        return ok ? v : fallback;
+    }
+    bool boolean(bool fallback = false) const noexcept {
+        uint8_t ok = 0;
+        uint8_t v = cs_bool_get_val(o_, &ok);
+        return ok ? v != 0 : fallback;
+    }
+
+    // members of an object, elements of an array
+    size_t size() const noexcept {
+        if (is_object())
+            return static_cast<cs_hash_tab *>(o_->data)->count;
+        if (is_array())
+            return static_cast<cs_dll *>(o_->data)->size;
+        return 0;
+    }
+
+    // the object's own hash table does the lookup, as cs_object_get_val would
+    value operator[](const key &k) const noexcept {
+        return is_object() ? value(cs_object_get_val(o_, k.str)) : value();
+    }
+    template <size_t N>
+    value operator[](const char (&s)[N]) const noexcept {
+        return (*this)[key(s)];
+    }
+    value operator[](const std::string &s) const noexcept {
+        return (*this)[key(s.c_str(), s.size())];
+    }
+    // O(index) on the underlying list: iterate instead of indexing in a loop
+    value operator[](size_t index) const noexcept {
+        return is_array() ? value(cs_array_get_val(o_, static_cast<uint32_t>(index))) : value();
+    }
+
+    class element_iterator;
+    class member_iterator;
+    struct elements_range;
+    struct members_range;
+
+    // for (cs::value e : v.elements()); empty unless v is an array
+    elements_range elements() const noexcept;
+    // for (auto [k, e] : v.members()); empty unless v is an object
+    members_range members() const noexcept;
+
+    // serialized, compactly
+    std::string dump() const {
+        std::string out;
+        cs_json_writer w;
+        if (o_ != nullptr && cs_writer_init_b(&w, 256)) {
+            if (cs_writer_value(&w, o_)) {
+                size_t len = 0;
+                const char *s = cs_writer_get_buf(&w, &len);
+                out.assign(s, len);
+            }
+            cs_writer_release(&w);
+        }
+        return out;
+    }
+
+    friend bool operator==(value a, value b) noexcept { return cs_object_equal(a.o_, b.o_) != 0; }
+    friend bool operator!=(value a, value b) noexcept { return !(a == b); }
+
+private:
+    cs_json_obj *o_;
+};
+
+// range-for adaptors over the C cursors (cs_array_iter, cs_object_iter)
+class value::element_iterator {
+public:
+    element_iterator() noexcept : it_{ nullptr }, cur_(nullptr) {}
+    explicit element_iterator(cs_json_obj *array) noexcept {
+        cs_array_iter_init(&it_, array);
+        cur_ = cs_array_iter_next(&it_);
+    }
+    value operator*() const noexcept { return value(cur_); }
+    element_iterator &operator++() noexcept {
+        cur_ = cs_array_iter_next(&it_);
+        return *this;
+    }
+    bool operator!=(const element_iterator &o) const noexcept { return cur_ != o.cur_; }
+    bool operator==(const element_iterator &o) const noexcept { return cur_ == o.cur_; }
+
+private:
+    cs_array_iter it_;
+    cs_json_obj *cur_;
+};
+
+struct member {
+    std::string_view key;
+    value val;
+};
+
+class value::member_iterator {
+public:
+    member_iterator() noexcept : it_{}, key_(nullptr), cur_(nullptr) {}
+    explicit member_iterator(cs_json_obj *object) noexcept : key_(nullptr), cur_(nullptr) {
+        cs_object_iter_init(&it_, object);
+        cs_object_iter_next(&it_, &key_, &cur_);
+    }
+    member operator*() const noexcept { return member{ key_, value(cur_) }; }
+    member_iterator &operator++() noexcept {
+        if (!cs_object_iter_next(&it_, &key_, &cur_))
+            cur_ = nullptr;
+        return *this;
+    }
+    bool operator!=(const member_iterator &o) const noexcept { return cur_ != o.cur_; }
+    bool operator==(const member_iterator &o) const noexcept { return cur_ == o.cur_; }
+
+private:
+    cs_object_iter it_;
+    const char *key_;
+    cs_json_obj *cur_;
+};
+
+struct value::elements_range {
+    element_iterator b, e;
+    element_iterator begin() const noexcept { return b; }
+    element_iterator end() const noexcept { return e; }
+};
+
+struct value::members_range {
+    member_iterator b, e;
+    member_iterator begin() const noexcept { return b; }
+    member_iterator end() const noexcept { return e; }
+};
+
+inline value::elements_range value::elements() const noexcept {
+    if (!is_array())
+        return elements_range{};
+    return elements_range{ element_iterator(o_), element_iterator() };
+}
+
+inline value::members_range value::members() const noexcept {
+    if (!is_object())
+        return members_range{};
+    return members_range{ member_iterator(o_), member_iterator() };
+}
+
+// sole owner of a tree: movable, not copyable, destroyed with the handle
+class document {
+public:
+    document() noexcept : root_(nullptr), error_(ERR_NONE) {}
+    explicit document(cs_json_obj *root) noexcept : root_(root), error_(ERR_NONE) {}
+    document(document &&o) noexcept : root_(std::exchange(o.root_, nullptr)), error_(o.error_) {}
+    document &operator=(document &&o) noexcept {
+        if (this != &o) {
+            reset();
+            root_ = std::exchange(o.root_, nullptr);
+            error_ = o.error_;
+        }
+        return *this;
+    }
+    document(const document &) = delete;
+    document &operator=(const document &) = delete;
+    ~document() { reset(); }
+
+    // len bytes at s, which must be followed by a '\0' (as for cs_parser_create_sn)
+    static document parse(const char *s, size_t len) {
+        document d;
+        cs_json_parser p;
+        if (!cs_parser_init_sn(&p, s, len)) {
+            d.error_ = ERR_ILLEGAL;
+            return d;
+        }
+        d.root_ = cs_json_parse(&p);
+        d.error_ = p.error;
+        return d;
+    }
+    static document parse(const std::string &s) { return parse(s.c_str(), s.size()); }
+
+    explicit operator bool() const noexcept { return root_ != nullptr; }
+    err_t error() const noexcept { return error_; }
+
+    value root() const noexcept { return value(root_); }
+    template <typename K>
+    value operator[](const K &k) const noexcept { return root()[k]; }
+    template <size_t N>
+    value operator[](const char (&s)[N]) const noexcept { return root()[key(s)]; }
+
+    // gives the tree up; the caller destroys it
+    cs_json_obj *release() noexcept { return std::exchange(root_, nullptr); }
+    void reset(cs_json_obj *root = nullptr) noexcept {
+        cs_object_destroy(std::exchange(root_, root));
+    }
+
+private:
+    cs_json_obj *root_;
+    err_t error_;
+};
+
+// a frozen tree shared between threads (doc.h): copies retain, destruction releases
+class shared {
+public:
+    shared() noexcept : d_(nullptr) {}
+    // freezes the document's tree and takes it over
+    explicit shared(document &&doc) : d_(nullptr) {
+        cs_json_obj *root = doc.release();
+        if (root != nullptr && (d_ = cs_doc_create(root)) == nullptr)
+            doc.reset(root);
+    }
+    // adopts a reference the caller holds (e.g. from cs_doc_acquire)
+    explicit shared(cs_json_doc *d) noexcept : d_(d) {}
+    shared(const shared &o) noexcept : d_(cs_doc_retain(o.d_)) {}
+    shared(shared &&o) noexcept : d_(std::exchange(o.d_, nullptr)) {}
+    shared &operator=(shared o) noexcept {
+        std::swap(d_, o.d_);
+        return *this;
+    }
+    ~shared() { cs_doc_release(d_); }
+
+    explicit operator bool() const noexcept { return d_ != nullptr; }
+    cs_json_doc *get() const noexcept { return d_; }
+
+    value root() const noexcept { return value(d_ ? cs_doc_root(d_) : nullptr); }
+    template <typename K>
+    value operator[](const K &k) const noexcept { return root()[k]; }
+    template <size_t N>
+    value operator[](const char (&s)[N]) const noexcept { return root()[key(s)]; }
+
+private:
+    cs_json_doc *d_;
+};
+
+} // namespace cs
+
+#endif
@@ -0,0 +1,96 @@
+// getline is POSIX rather than C99
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "eurysta.h"
+
+// to compile:
+// gcc parser.c c_data_structs/cs_hash_tab.c c_data_structs/cs_linked_list.c object.c bind.c batch.c pool.c arena.c writer.c source.c cache.c doc.c validate.c project.c -std=c99 filter.c -o filter -O2 -lpthread
+//
+// usage: filter [-w path=json]... [-x path=json]... [file] -- field...
+//  prints the given fields of every record (one per line, or the elements of a top-level
+//  array) that has the value json at each -w path and doesn't at each -x path, e.g.
+//  filter -w 'type="click"' events.ndjson -- user.id ts
+//  reads standard input, line by line, when no file is given
+
+// the projection window: the mapped file is read ahead, and dropped behind, this much at a time
+#define FILTER_WINDOW (64 << 20)
+
+static int usage_(void) {
+    fprintf(stderr, "usage: filter [-w path=json]... [-x path=json]... [file] -- field...\n");
+    return 2;
+}
+
+int main(int argc, const char **argv) {
+    cs_projection *pr = cs_projection_create();
+    const char *file = NULL;
+    int i = 1;
+
+    for (; i < argc && strcmp(argv[i], "--") != 0; i++) {
+        if (strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "-x") == 0) {
+            const char *cond = (i + 1 < argc) ? argv[i + 1] : NULL;
+            const char *eq = (cond != NULL) ? strchr(cond, '=') : NULL;
+            if (eq == NULL)
+                return usage_();
+            char *path = strndup(cond, eq - cond);
+            cs_projection_where(pr, path, eq + 1, argv[i][1] == 'x');
+            free(path);
+            i++;
+        }
+        else if (file == NULL) {
+            file = argv[i];
+        }
+        else {
+            return usage_();
+        }
+    }
+    if (i + 1 >= argc)
+        return usage_();
+    for (i++; i < argc; i++) {
+        if (!cs_projection_add(pr, argv[i])) {
+            fprintf(stderr, "filter: bad field '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+
+    cs_json_writer w;
+    cs_writer_init_f(&w, stdout);
+    err_t error = ERR_NONE;
+    uint64_t line = 0;
+
+    if (file != NULL) {
+        cs_json_parser *p = cs_parser_create_fmm_opt(file, 0, FILTER_WINDOW);
+        if (p == NULL) {
+            fprintf(stderr, "filter: can't open '%s'\n", file);
+            return 1;
+        }
+        cs_json_project(p, pr, &w);
+        if ((error = p->error) != ERR_NONE)
+            fprintf(stderr, "filter: %s at byte %llu\n", cs_strerror(error), (unsigned long long)p->position);
+        cs_parser_destroy(p);
+    }
+    else {
+        cs_json_parser p;
+        char *buf = NULL;
+        size_t cap = 0;
+        ssize_t len;
+        while ((len = getline(&buf, &cap, stdin)) > 0) {
+            line++;
+            cs_parser_init_sn(&p, buf, (size_t)len);
+            cs_json_project(&p, pr, &w);
+            if ((error = p.error) != ERR_NONE) {
+                fprintf(stderr, "filter: %s on line %llu\n", cs_strerror(error), (unsigned long long)line);
+                break;
+            }
+        }
+        free(buf);
+    }
+
+    cs_writer_release(&w);
+    cs_projection_destroy(pr);
+    return error != ERR_NONE;
+}
@@ -25,13 +25,19 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+// strndup is POSIX, not C99
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 #include "eurysta.h"
 
 // global "null" object
-cs_json_obj null_ = { OBJ_TYPE_NULL, NULL };
+cs_json_obj null_ = { OBJ_TYPE_NULL, 0, NULL };
 
 static inline void spec_destructor_(const char *k, void *v) {
     cs_json_obj *obj = (cs_json_obj *)v;
@@ -43,90 +49,102 @@ static inline void spec_destructor_(const char *k, void *v) {
             cs_dll_destroy(obj->data);
             break;
         case OBJ_TYPE_STRING:
-            free(obj->data);
+            if (!(obj->flags & OBJ_FLAG_BORROWED))
+                free(obj->data);
             break;
         case OBJ_TYPE_NUMBER:
-            free(obj->data);
+            if ((obj->flags & (OBJ_FLAG_RAW | OBJ_FLAG_BORROWED)) == OBJ_FLAG_RAW)
+                free((char *)((struct cs_number_raw *)obj->data)->text);
+            cs_pool_put_node(obj->data);
             break;
         case OBJ_TYPE_NULL:
             return;
     }
-    free(obj);
+    if (obj->flags & OBJ_FLAG_SPAN)
+        cs_pool_put_span(obj);
+    else
+        cs_pool_put_node(obj);
 }
 
-static void generic_destructor_(void *v) {
-    spec_destructor_(NULL, v);
+// a modified value's span, and the spans of all the containers above it, are stale;
+//  the walk up stops at the first node that is already dirty (or has no span)
+static void touch_(cs_json_obj *o) {
+    while (o != NULL && (o->flags & (OBJ_FLAG_SPAN | OBJ_FLAG_DIRTY)) == OBJ_FLAG_SPAN) {
+        o->flags |= OBJ_FLAG_DIRTY;
+        o = ((struct cs_json_span *)o)->parent;
+    }
 }
 
-static inline void print_string_(const char *s, FILE *f) {
-    putc('"', f);
-    while (*s) {
-        if (*s == '"')
-            putc('\\', f);
-        putc(*s++, f);
-    }
-    putc('"', f);
+static inline uint8_t frozen_(cs_json_obj *o) {
+    return (o->flags & OBJ_FLAG_FROZEN) != 0;
 }
 
-static inline void print_hash_(cs_hash_tab *t, FILE *f) {
-    putc('{', f);
-    for (size_t i = 0, c = 0; i < t->size, c < t->count; i++) {
-        for (cs_knode *n = t->buckets[i]; n != NULL; n = n->next) {
-            print_string_(n->key, f);
-            putc(':', f);
-            cs_object_print(n->val, f);
-            if (t->count - c++ > 1)
-                putc(',', f);
-        }
-    }
-    putc('}', f);
+static inline void adopt_(cs_json_obj *container, cs_json_obj *value) {
+    if (value != NULL && (value->flags & OBJ_FLAG_SPAN))
+        ((struct cs_json_span *)value)->parent = container;
 }
 
-static inline void print_array_(cs_dll *list, FILE *f) {
-    putc('[', f);
-    cs_dll_node *n = list->start;
-    for (int i = 0; n != NULL; i++, n = n->next) {
-        cs_object_print((cs_json_obj *)n->data, f);
-        if (i < list->size - 1)
-            putc(',', f);
-    }
-    putc(']', f);
+static void generic_destructor_(void *v) {
+    spec_destructor_(NULL, v);
 }
 
 void cs_object_destroy(cs_json_obj *o) {
-    generic_destructor_(o);
+    // a frozen tree belongs to its document
+    if (o != NULL && !frozen_(o))
+        generic_destructor_(o);
 }
 
-void cs_object_print(cs_json_obj *obj, FILE *f) {
-    switch (obj->type) {
-        case OBJ_TYPE_STRING:
-            print_string_((const char *)obj->data, f);
-            break;
-        case OBJ_TYPE_NUMBER:
-            fprintf(f, "%g", *(double *)obj->data);
-            break;
-        case OBJ_TYPE_OBJECT:
-            print_hash_((cs_hash_tab *)obj->data, f);
-            break;
-        case OBJ_TYPE_ARRAY:
-            print_array_((cs_dll *)obj->data, f);
-            break;
-        case OBJ_TYPE_NULL:
-            fprintf(f, "null");
-            break;
-        case OBJ_TYPE_BOOL:
-            fprintf(f, "%s", ((uintptr_t)obj->data & 1) ? "true" : "false");
+void cs_object_destroy_frozen(cs_json_obj *o) {
+    if (o != NULL)
+        generic_destructor_(o);
+}
+
+cs_json_obj *cs_span_attach(cs_json_obj *o) {
+    if (o == NULL || o == &null_ || (o->flags & OBJ_FLAG_SPAN))
+        return o;
+
+    struct cs_json_span *s = cs_pool_get_span();
+    if (s == NULL) {
+        cs_object_destroy(o);
+        return NULL;
     }
+    s->obj = *o;
+    s->obj.flags |= OBJ_FLAG_SPAN | OBJ_FLAG_DIRTY;
+    s->parent = NULL;
+    s->start = NULL;
+    s->len = 0;
+    cs_pool_put_node(o);
+    return &s->obj;
+}
+
+uint8_t cs_object_print(cs_json_obj *obj, FILE *f) {
+    cs_json_writer w;
+    cs_writer_init_f(&w, f);
+    uint8_t ok = cs_writer_value(&w, obj);
+    cs_writer_release(&w);
+    return ok;
 }
 
 cs_json_obj *cs_object_create(void) {
-    cs_json_obj *obj = malloc(sizeof(cs_json_obj));
+    return cs_object_create_n(0);
+}
+
+cs_json_obj *cs_object_create_n(size_t hint) {
+    // enough buckets to hold hint members below the 0.75 load factor
+    uint32_t buckets = 32;
+    if (hint > 0) {
+        for (buckets = 2; buckets * 3 / 4 < hint; buckets <<= 1)
+            ;
+    }
+
+    cs_json_obj *obj = cs_pool_get_node();
     if (obj == NULL)
         return NULL;
         
     obj->type = OBJ_TYPE_OBJECT;
-    if ((obj->data = cs_hash_create_opt(32, 0.75f, 0.25f)) == NULL) {
-        free(obj);
+    obj->flags = 0;
+    if ((obj->data = cs_hash_create_opt(buckets, 0.75f, 0.25f)) == NULL) {
+        cs_pool_put_node(obj);
         return NULL;
     }
 
@@ -137,13 +155,14 @@ cs_json_obj *cs_object_create(void) {
 }
 
 cs_json_obj *cs_array_create(void) {
-    cs_json_obj *obj = malloc(sizeof(cs_json_obj));
+    cs_json_obj *obj = cs_pool_get_node();
     if (obj == NULL)
         return NULL;
     
     obj->type = OBJ_TYPE_ARRAY;
+    obj->flags = 0;
     if ((obj->data = cs_dll_create(generic_destructor_, NULL)) == NULL) {
-        free(obj);
+        cs_pool_put_node(obj);
         return NULL;
     }
     
@@ -151,11 +170,12 @@ cs_json_obj *cs_array_create(void) {
 }
 
 cs_json_obj *cs_bool_create(uint8_t val) {
-    cs_json_obj *obj = malloc(sizeof(cs_json_obj));
+    cs_json_obj *obj = cs_pool_get_node();
     if (obj == NULL)
         return NULL;
     
     obj->type = OBJ_TYPE_BOOL;
+    obj->flags = 0;
     obj->data = (void *)(uintptr_t)(val & 1);
     
     return obj;
@@ -165,24 +185,29 @@ cs_json_obj *cs_string_create(char *val, uint8_t assign) {
     if (val == NULL)
         return NULL;
 
-    cs_json_obj *str = malloc(sizeof(cs_json_obj));
+    cs_json_obj *str = cs_pool_get_node();
     if (str == NULL)
         return NULL;
         
     str->type = OBJ_TYPE_STRING;
-    str->data = (assign) ? val : strdup(val);
+    str->flags = (assign == CS_STR_BORROW) ? OBJ_FLAG_BORROWED : 0;
+    if ((str->data = (assign != CS_STR_COPY) ? val : strdup(val)) == NULL) {
+        cs_pool_put_node(str);
+        return NULL;
+    }
     
     return str;
 }
 
 cs_json_obj *cs_number_create(double val) {
-    cs_json_obj *num = malloc(sizeof(cs_json_obj));
+    cs_json_obj *num = cs_pool_get_node();
     if (num == NULL)
         return NULL;
     
     num->type = OBJ_TYPE_NUMBER;
-    if ((num->data = malloc(sizeof(double))) == NULL) {
-        free(num);
+    num->flags = 0;
+    if ((num->data = cs_pool_get_node()) == NULL) {
+        cs_pool_put_node(num);
         return NULL;
     }
     
@@ -191,6 +216,55 @@ cs_json_obj *cs_number_create(double val) {
     return num;
 }
 
+cs_json_obj *cs_number_create_raw(const char *text, uint8_t assign) {
+    if (text == NULL)
+        return NULL;
+
+    cs_json_obj *num = cs_number_create(0);
+    if (num == NULL)
+        return NULL;
+
+    struct cs_number_raw *raw = num->data;
+    if ((raw->text = (assign != CS_STR_COPY) ? text : strdup(text)) == NULL) {
+        cs_object_destroy(num);
+        return NULL;
+    }
+    num->flags = OBJ_FLAG_RAW | ((assign == CS_STR_BORROW) ? OBJ_FLAG_BORROWED : 0);
+
+    return num;
+}
+
+// length of a raw number's text, which ends at the first character that can't be part of one
+static size_t raw_len_(const char *text) {
+    size_t n = 0;
+    for (char c = text[0]; (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'; c = text[++n])
+        ;
+    return n;
+}
+
+// converts a raw number's text the first time its value is asked for
+static inline double number_val_(cs_json_obj *number) {
+    if ((number->flags & (OBJ_FLAG_RAW | OBJ_FLAG_CONVERTED)) == OBJ_FLAG_RAW) {
+        struct cs_number_raw *raw = number->data;
+        // borrowed text runs on into the rest of the input: strtod only gets the literal
+        char buffer[64];
+        size_t len = raw_len_(raw->text);
+        char *copy = (len < sizeof(buffer)) ? buffer : malloc(len + 1);
+        if (copy != NULL) {
+            memcpy(copy, raw->text, len);
+            copy[len] = '\0';
+            raw->val = strtod(copy, NULL);
+            if (copy != buffer)
+                free(copy);
+        }
+        else {
+            raw->val = 0;
+        }
+        number->flags |= OBJ_FLAG_CONVERTED;
+    }
+    return *(double *)number->data;
+}
+
 char *cs_string_get_val(cs_json_obj *string) {
     if (string != NULL && string->type == OBJ_TYPE_STRING) {
         return string->data;
@@ -199,10 +273,15 @@ char *cs_string_get_val(cs_json_obj *string) {
 }
 
 uint8_t cs_string_set_val(cs_json_obj *string, const char *value) {
-    if (string != NULL && string->type == OBJ_TYPE_STRING) {
-        // FIXME: it's unsafe to assume the previous value was dynamically allocated
-        free(string->data);
-        string->data = strdup(value);
+    if (string != NULL && string->type == OBJ_TYPE_STRING && !frozen_(string)) {
+        char *copy = strdup(value);
+        if (copy == NULL)
+            return 0;
+        if (!(string->flags & OBJ_FLAG_BORROWED))
+            free(string->data);
+        string->data = copy;
+        string->flags &= ~OBJ_FLAG_BORROWED;
+        touch_(string);
         return 1;
     }
     return 0;
@@ -217,7 +296,7 @@ double cs_number_get_val(cs_json_obj *number, uint8_t *success) {
     double v = 0;
     if (number != NULL && number->type == OBJ_TYPE_NUMBER) {
         s = 1;
-        v = *(double *)number->data;
+        v = number_val_(number);
     }
     if (success != NULL)
         *success = s;
@@ -225,14 +304,62 @@ double cs_number_get_val(cs_json_obj *number, uint8_t *success) {
 }
 
 uint8_t cs_number_set_val(cs_json_obj *number, double value) {
+    if (number != NULL && number->type == OBJ_TYPE_NUMBER && !frozen_(number)) {
+        // the text no longer describes the number
+        if ((number->flags & (OBJ_FLAG_RAW | OBJ_FLAG_BORROWED)) == OBJ_FLAG_RAW)
+            free((char *)((struct cs_number_raw *)number->data)->text);
+        number->flags &= ~(OBJ_FLAG_RAW | OBJ_FLAG_CONVERTED | OBJ_FLAG_BORROWED);
+
+        // the payload is ours, overwrite it in place
+        *(double *)number->data = value;
+        touch_(number);
+        return 1;
+    }
+    return 0;
+}
+
+int64_t cs_number_get_int(cs_json_obj *number, uint8_t *success) {
+    uint8_t s = 0;
+    int64_t v = 0;
     if (number != NULL && number->type == OBJ_TYPE_NUMBER) {
-        free(number->data);
-        if ((number->data = malloc(sizeof(double))) != NULL) {
-            *(double *)number->data = value;
-            return 1;
+        size_t len = 0, i = 0;
+        const char *text = cs_number_get_raw(number, &len);
+        // borrowed text isn't NUL-terminated, nothing may look past len
+        while (text != NULL && i < len && text[i] != '.' && text[i] != 'e' && text[i] != 'E')
+            i++;
+        // integer literals are converted exactly, without a trip through double
+        if (text != NULL && i == len) {
+            // 20 digits and a sign hold any int64_t; a longer literal can't fit
+            char buffer[24];
+            if (len < sizeof(buffer)) {
+                memcpy(buffer, text, len);
+                buffer[len] = '\0';
+                errno = 0;
+                v = strtoll(buffer, NULL, 10);
+                s = (errno != ERANGE);
+            }
+        }
+        else {
+            double d = number_val_(number);
+            if (d >= -9223372036854775808.0 && d < 9223372036854775808.0 && d == (double)(int64_t)d) {
+                v = (int64_t)d;
+                s = 1;
+            }
         }
     }
-    return 0;
+    if (success != NULL)
+        *success = s;
+    return v;
+}
+
+const char *cs_number_get_raw(cs_json_obj *number, size_t *len) {
+    if (number == NULL || number->type != OBJ_TYPE_NUMBER || !(number->flags & OBJ_FLAG_RAW))
+        return NULL;
+
+    const char *text = ((struct cs_number_raw *)number->data)->text;
+    if (len != NULL)
+        *len = raw_len_(text);
+    return text;
 }
 
 uint8_t cs_bool_get_val(cs_json_obj *boolean, uint8_t *success) {
@@ -247,8 +374,9 @@ uint8_t cs_bool_get_val(cs_json_obj *boolean, uint8_t *success) {
 }
 
 uint8_t cs_bool_set_val(cs_json_obj *boolean, uint8_t value) {
-    if (boolean != NULL && boolean->type == OBJ_TYPE_BOOL) {
+    if (boolean != NULL && boolean->type == OBJ_TYPE_BOOL && !frozen_(boolean)) {
         boolean->data = (void *)((uintptr_t)value & 1);
+        touch_(boolean);
         return 1;
     }
     return 0;
@@ -262,9 +390,12 @@ cs_json_obj *cs_object_get_val(cs_json_obj *object, const char *key) {
 }
 
 uint8_t cs_object_set_val(cs_json_obj *object, const char *key, cs_json_obj *value) {
-    if (object != NULL && object->type == OBJ_TYPE_OBJECT) {
+    // a frozen value belongs to some document, it can't be moved into another tree
+    if (object != NULL && object->type == OBJ_TYPE_OBJECT && !frozen_(object) && (value == NULL || !frozen_(value))) {
         if (object->data != NULL) {
             cs_hash_set((cs_hash_tab *)object->data, key, value);
+            adopt_(object, value);
+            touch_(object);
             return 1;
         }
     }
@@ -272,14 +403,16 @@ uint8_t cs_object_set_val(cs_json_obj *object, const char *key, cs_json_obj *val
 }
 
 inline size_t cs_object_get_size(cs_json_obj *object) {
-    return ((cs_hash_tab *)object)->count;
+    return ((cs_hash_tab *)object->data)->count;
 }
 
 void cs_object_del_val(cs_json_obj *object, const char *key) {
-    if (object && object->type == OBJ_TYPE_OBJECT) {
+    if (object && object->type == OBJ_TYPE_OBJECT && !frozen_(object)) {
         cs_json_obj *o = cs_hash_del((cs_hash_tab *)object->data, key);
-        if (o)
+        if (o) {
             cs_object_destroy(o);
+            touch_(object);
+        }
     }
 }
 
@@ -291,22 +424,401 @@ cs_json_obj *cs_array_get_val(cs_json_obj *array, uint32_t index) {
 }
 
 uint8_t cs_array_set_val(cs_json_obj *array, uint32_t index, cs_json_obj *value) {
-    if (array != NULL && array->type == OBJ_TYPE_ARRAY) {
-        if (array->data) {
-            return cs_dll_set((cs_dll *)array->data, value, index);
+    if (array != NULL && array->type == OBJ_TYPE_ARRAY && !frozen_(array) && (value == NULL || !frozen_(value))) {
+        if (array->data && cs_dll_set((cs_dll *)array->data, value, index)) {
+            adopt_(array, value);
+            touch_(array);
+            return 1;
         }
     }
     return 0;
 }
 
 void cs_array_del_val(cs_json_obj *array, uint32_t index) {
-    if (array && array->type == OBJ_TYPE_ARRAY) {
+    if (array && array->type == OBJ_TYPE_ARRAY && !frozen_(array)) {
         cs_json_obj *o = cs_dll_del((cs_dll *)array->data, index);
-        if (o)
+        if (o) {
             cs_object_destroy(o);
+            touch_(array);
+        }
     }
 }
 
+cs_json_obj *cs_object_take(cs_json_obj *object, const char *key) {
+    if (object == NULL || object->type != OBJ_TYPE_OBJECT || frozen_(object))
+        return NULL;
+    cs_json_obj *o = cs_hash_del((cs_hash_tab *)object->data, key);
+    if (o != NULL) {
+        adopt_(NULL, o);
+        touch_(object);
+    }
+    return o;
+}
+
+cs_json_obj *cs_array_take(cs_json_obj *array, uint32_t index) {
+    if (array == NULL || array->type != OBJ_TYPE_ARRAY || frozen_(array))
+        return NULL;
+    cs_json_obj *o = cs_dll_del((cs_dll *)array->data, index);
+    if (o != NULL) {
+        adopt_(NULL, o);
+        touch_(array);
+    }
+    return o;
+}
+
+cs_json_obj *cs_array_swap(cs_json_obj *array, uint32_t index, cs_json_obj *value) {
+    if (array == NULL || value == NULL || array->type != OBJ_TYPE_ARRAY || frozen_(array) || frozen_(value))
+        return NULL;
+    cs_dll *l = array->data;
+    if (index >= l->size)
+        return NULL;
+
+    // walk from whichever end is closer
+    cs_dll_node *n;
+    if (index < l->size / 2) {
+        n = l->start;
+        for (uint32_t i = 0; i < index; i++)
+            n = n->next;
+    }
+    else {
+        n = l->end;
+        for (size_t i = l->size - 1; i > index; i--)
+            n = n->prev;
+    }
+    cs_json_obj *old = n->data;
+    n->data = value;
+    adopt_(NULL, old);
+    adopt_(array, value);
+    touch_(array);
+    return old;
+}
+
+uint8_t cs_array_insert(cs_json_obj *array, uint32_t index, cs_json_obj *value) {
+    if (array == NULL || value == NULL || array->type != OBJ_TYPE_ARRAY || frozen_(array) || frozen_(value))
+        return 0;
+    cs_dll *l = array->data;
+    size_t size = l->size;
+    if (index > size)
+        return 0;
+
+    cs_dll_node *at = NULL;
+    if (index < size) {
+        at = l->start;
+        for (uint32_t i = 0; i < index; i++)
+            at = at->next;
+    }
+    cs_dll_app(l, value);
+    if (l->size != size + 1)
+        return 0;
+
+    // the list can only append: shift the elements from index on up by one, into the new node
+    if (at != NULL) {
+        for (cs_dll_node *n = l->end; n != at; n = n->prev)
+            n->data = n->prev->data;
+        at->data = value;
+    }
+    adopt_(array, value);
+    touch_(array);
+    return 1;
+}
+
 inline size_t cs_array_get_len(cs_json_obj *array) {
     return ((cs_dll *)array->data)->size;
 }
+
+void cs_object_iter_init(cs_object_iter *it, cs_json_obj *object) {
+    it->node = NULL;
+    it->remaining = 0;
+    if (object == NULL || object->type != OBJ_TYPE_OBJECT)
+        return;
+
+    cs_hash_tab *t = object->data;
+    it->tab = t;
+    it->remaining = t->count;
+    for (it->bucket = 0; it->remaining > 0 && it->bucket < t->size; it->bucket++) {
+        if ((it->node = t->buckets[it->bucket]) != NULL)
+            break;
+    }
+}
+
+uint8_t cs_object_iter_next(cs_object_iter *it, const char **key, cs_json_obj **value) {
+    cs_knode *n = it->node;
+    if (n == NULL)
+        return 0;
+    if (key != NULL)
+        *key = n->key;
+    if (value != NULL)
+        *value = n->val;
+
+    // find the member after this one now, so it's on its way in by the time it's asked for;
+    //  counting members means the empty buckets past the last one are never visited
+    cs_knode *next = n->next;
+    if (next == NULL && --it->remaining > 0) {
+        cs_hash_tab *t = it->tab;
+        while (++it->bucket < t->size && (next = t->buckets[it->bucket]) == NULL)
+            ;
+    }
+    else if (next != NULL) {
+        it->remaining--;
+    }
+    if (next != NULL)
+        __builtin_prefetch(next);
+    it->node = next;
+    return 1;
+}
+
+void cs_array_iter_init(cs_array_iter *it, cs_json_obj *array) {
+    it->node = (array != NULL && array->type == OBJ_TYPE_ARRAY) ? ((cs_dll *)array->data)->start : NULL;
+}
+
+cs_json_obj *cs_array_iter_next(cs_array_iter *it) {
+    cs_dll_node *n = it->node;
+    if (n == NULL)
+        return NULL;
+    if (n->next != NULL)
+        __builtin_prefetch(n->next);
+    it->node = n->next;
+    return n->data;
+}
+
+void cs_object_freeze(cs_json_obj *o) {
+    // the shared null is never written to, not even its flags
+    if (o == &null_ || frozen_(o))
+        return;
+
+    switch (o->type) {
+        case OBJ_TYPE_OBJECT: {
+            cs_hash_tab *t = o->data;
+            for (uint32_t i = 0; i < t->size; i++) {
+                for (cs_knode *n = t->buckets[i]; n != NULL; n = n->next)
+                    cs_object_freeze(n->val);
+            }
+            break;
+        }
+        case OBJ_TYPE_ARRAY:
+            for (cs_dll_node *n = ((cs_dll *)o->data)->start; n != NULL; n = n->next)
+                cs_object_freeze(n->data);
+            break;
+        case OBJ_TYPE_NUMBER:
+            // converting on first read would be a write; do it now, while there is one owner
+            number_val_(o);
+            break;
+        default:
+            break;
+    }
+    o->flags |= OBJ_FLAG_FROZEN;
+}
+
+cs_json_obj *cs_object_clone(cs_json_obj *o) {
+    if (o == NULL || o == &null_)
+        return o;
+
+    cs_json_obj *c = NULL;
+    switch (o->type) {
+        case OBJ_TYPE_OBJECT: {
+            cs_object_iter it;
+            const char *key;
+            cs_json_obj *val;
+            if ((c = cs_object_create_n(((cs_hash_tab *)o->data)->count)) == NULL)
+                return NULL;
+            cs_object_iter_init(&it, o);
+            while (cs_object_iter_next(&it, &key, &val)) {
+                char *k = strdup(key);
+                cs_json_obj *v = cs_object_clone(val);
+                if (k == NULL || v == NULL || !cs_object_set_val(c, k, v)) {
+                    free(k);
+                    cs_object_destroy(v);
+                    cs_object_destroy(c);
+                    return NULL;
+                }
+            }
+            return c;
+        }
+        case OBJ_TYPE_ARRAY: {
+            cs_array_iter it;
+            cs_json_obj *val;
+            if ((c = cs_array_create()) == NULL)
+                return NULL;
+            cs_array_iter_init(&it, o);
+            while ((val = cs_array_iter_next(&it)) != NULL) {
+                cs_json_obj *v = cs_object_clone(val);
+                size_t size = ((cs_dll *)c->data)->size;
+                if (v != NULL)
+                    cs_dll_app((cs_dll *)c->data, v);
+                if (v == NULL || ((cs_dll *)c->data)->size != size + 1) {
+                    cs_object_destroy(v);
+                    cs_object_destroy(c);
+                    return NULL;
+                }
+            }
+            return c;
+        }
+        case OBJ_TYPE_STRING:
+            return cs_string_create(o->data, CS_STR_COPY);
+        case OBJ_TYPE_NUMBER: {
+            // keep the literal, if there is one (it's not NUL-terminated in the input)
+            size_t len = 0;
+            const char *text = cs_number_get_raw(o, &len);
+            if (text == NULL)
+                return cs_number_create(number_val_(o));
+            char *copy = strndup(text, len);
+            if (copy == NULL || (c = cs_number_create_raw(copy, CS_STR_MOVE)) == NULL)
+                free(copy);
+            return c;
+        }
+        case OBJ_TYPE_BOOL:
+            return cs_bool_create((uintptr_t)o->data & 1);
+        case OBJ_TYPE_NULL:
+            break;
+    }
+    return &null_;
+}
+
+size_t cs_object_footprint(cs_json_obj *o) {
+    if (o == NULL || o == &null_)
+        return 0;
+
+    size_t n = (o->flags & OBJ_FLAG_SPAN) ? sizeof(struct cs_json_span) : CS_POOL_NODE_SIZE;
+    switch (o->type) {
+        case OBJ_TYPE_OBJECT: {
+            cs_hash_tab *t = o->data;
+            cs_object_iter it;
+            const char *key;
+            cs_json_obj *val;
+            n += sizeof(cs_hash_tab) + t->size * sizeof(cs_knode *);
+            cs_object_iter_init(&it, o);
+            while (cs_object_iter_next(&it, &key, &val))
+                n += sizeof(cs_knode) + strlen(key) + 1 + cs_object_footprint(val);
+            break;
+        }
+        case OBJ_TYPE_ARRAY: {
+            cs_array_iter it;
+            cs_json_obj *val;
+            n += sizeof(cs_dll);
+            cs_array_iter_init(&it, o);
+            while ((val = cs_array_iter_next(&it)) != NULL)
+                n += sizeof(cs_dll_node) + cs_object_footprint(val);
+            break;
+        }
+        case OBJ_TYPE_STRING:
+            if (!(o->flags & OBJ_FLAG_BORROWED))
+                n += strlen(o->data) + 1;
+            break;
+        case OBJ_TYPE_NUMBER:
+            // the payload, and the literal if it's ours
+            n += CS_POOL_NODE_SIZE;
+            if ((o->flags & (OBJ_FLAG_RAW | OBJ_FLAG_BORROWED)) == OBJ_FLAG_RAW)
+                n += strlen(((struct cs_number_raw *)o->data)->text) + 1;
+            break;
+        default:
+            break;
+    }
+    return n;
+}
+
+// murmur3's finalizer: every input bit affects every output bit
+static inline uint64_t mix_(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t cs_json_hash_bytes(const void *data, size_t len) {
+    const unsigned char *b = data;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ len;
+
+    // a word at a time; memcpy keeps unaligned loads legal and compiles to a single mov
+    for (; len >= 8; b += 8, len -= 8) {
+        uint64_t w;
+        memcpy(&w, b, 8);
+        h ^= w * 0x87c37b91114253d5ULL;
+        h = ((h << 31) | (h >> 33)) * 0x4cf5ad432745937fULL;
+    }
+    uint64_t w = 0;
+    for (size_t i = 0; i < len; i++)
+        w |= (uint64_t)b[i] << (i * 8);
+    return mix_(h ^ w);
+}
+
+uint64_t cs_object_hash(cs_json_obj *obj) {
+    switch (obj->type) {
+        case OBJ_TYPE_OBJECT: {
+            // members are summed, so the order they are stored (or were written) in is irrelevant
+            cs_hash_tab *t = obj->data;
+            uint64_t sum = 0;
+            for (uint32_t i = 0; i < t->size; i++) {
+                for (cs_knode *n = t->buckets[i]; n != NULL; n = n->next)
+                    sum += mix_(cs_json_hash_bytes(n->key, strlen(n->key)) + 31 * cs_object_hash(n->val));
+            }
+            return mix_(sum ^ ((uint64_t)t->count << 3 | OBJ_TYPE_OBJECT));
+        }
+        case OBJ_TYPE_ARRAY: {
+            uint64_t h = OBJ_TYPE_ARRAY;
+            for (cs_dll_node *n = ((cs_dll *)obj->data)->start; n != NULL; n = n->next)
+                h = mix_(h * 31 + cs_object_hash(n->data));
+            return h;
+        }
+        case OBJ_TYPE_STRING:
+            return cs_json_hash_bytes(obj->data, strlen(obj->data)) ^ OBJ_TYPE_STRING;
+        case OBJ_TYPE_NUMBER: {
+            // by value: 1, 1.0 and 10e-1 are the same number; so are 0 and -0
+            double v = number_val_(obj);
+            uint64_t bits = 0;
+            if (v != 0)
+                memcpy(&bits, &v, sizeof(bits));
+            return mix_(bits ^ OBJ_TYPE_NUMBER);
+        }
+        case OBJ_TYPE_BOOL:
+            return mix_(((uintptr_t)obj->data & 1) + 1) ^ OBJ_TYPE_BOOL;
+        case OBJ_TYPE_NULL:
+            break;
+    }
+    return mix_(OBJ_TYPE_NULL);
+}
+
+uint8_t cs_object_equal(cs_json_obj *a, cs_json_obj *b) {
+    if (a == b)
+        return 1;
+    if (a == NULL || b == NULL || a->type != b->type)
+        return 0;
+
+    switch (a->type) {
+        case OBJ_TYPE_OBJECT: {
+            cs_hash_tab *ta = a->data, *tb = b->data;
+            if (ta->count != tb->count)
+                return 0;
+            // same size, so every key of a found in b means the key sets are equal
+            for (uint32_t i = 0; i < ta->size; i++) {
+                for (cs_knode *n = ta->buckets[i]; n != NULL; n = n->next) {
+                    cs_json_obj *v = cs_hash_get(tb, n->key);
+                    if (v == NULL || !cs_object_equal(n->val, v))
+                        return 0;
+                }
+            }
+            return 1;
+        }
+        case OBJ_TYPE_ARRAY: {
+            cs_dll *la = a->data, *lb = b->data;
+            if (la->size != lb->size)
+                return 0;
+            cs_dll_node *na = la->start, *nb = lb->start;
+            for (; na != NULL && nb != NULL; na = na->next, nb = nb->next) {
+                if (!cs_object_equal(na->data, nb->data))
+                    return 0;
+            }
+            return 1;
+        }
+        case OBJ_TYPE_STRING:
+            return strcmp(a->data, b->data) == 0;
+        case OBJ_TYPE_NUMBER:
+            return number_val_(a) == number_val_(b);
+        case OBJ_TYPE_BOOL:
+            return ((uintptr_t)a->data & 1) == ((uintptr_t)b->data & 1);
+        case OBJ_TYPE_NULL:
+            break;
+    }
+    return 1;
+}
@@ -41,33 +41,87 @@ enum obj_type {
     OBJ_TYPE_NULL
 };
 
+// cs_json_obj.flags
+#define OBJ_FLAG_BORROWED  0x01  // data (or a number's text) is not ours to free
+#define OBJ_FLAG_RAW       0x02  // a number that kept its literal text (struct cs_number_raw)
+#define OBJ_FLAG_CONVERTED 0x04  // ...whose text has been converted and cached
+#define OBJ_FLAG_SPAN      0x08  // the node is a struct cs_json_span (CS_PARSE_SPANS)
+#define OBJ_FLAG_DIRTY     0x10  // ...changed since it was parsed; its span no longer applies
+#define OBJ_FLAG_FROZEN    0x20  // read-only (cs_object_freeze): setters fail, destroy ignores it
+
+// ownership modes for cs_string_create
+#define CS_STR_COPY   0   // the string is duplicated
+#define CS_STR_MOVE   1   // the malloc'd string is adopted and freed with the object
+#define CS_STR_BORROW 2   // the string is referenced only; it must outlive the object (e.g. an arena)
+
 struct cs_json_obj {
     enum obj_type type;
+    uint8_t flags;
     void *data;
 };
 
 typedef struct cs_json_obj cs_json_obj;
 
-void cs_object_print(cs_json_obj *obj, FILE *f);
+// payload of a number with OBJ_FLAG_RAW; val comes first so it reads like any other number
+struct cs_number_raw {
+    double val;
+    const char *text;   // the literal as it appeared in the input, not NUL-terminated
+};
+
+// a node that remembers where it came from in the input, so the writer can copy it back out
+//  verbatim for as long as neither it nor anything below it has been modified; the setters
+//  mark the node and every span node above it (through parent) dirty
+struct cs_json_span {
+    cs_json_obj obj;
+    cs_json_obj *parent;    // the container holding it, NULL at the root
+    const char *start;      // the value's text in the input, not NUL-terminated
+    size_t len;
+};
+
+// 0 when out of memory
+uint8_t cs_object_print(cs_json_obj *obj, FILE *f);
 
 cs_json_obj *cs_object_create(void);
 
+// an object expected to hold about hint members (0 for the default sizing)
+cs_json_obj *cs_object_create_n(size_t hint);
+
 cs_json_obj *cs_array_create(void);
 
 cs_json_obj *cs_bool_create(uint8_t val);
 
+// assign is one of CS_STR_COPY, CS_STR_MOVE or CS_STR_BORROW
 cs_json_obj *cs_string_create(char *val, uint8_t assign);
 
 cs_json_obj *cs_number_create(double val);
 
+// a number given by its literal text, converted on first use; assign is one of CS_STR_*
+cs_json_obj *cs_number_create_raw(const char *text, uint8_t assign);
+
+// does nothing to a frozen tree; that is released through its document (doc.h)
 void cs_object_destroy(cs_json_obj *o);
 
+// makes the whole tree read-only: every setter fails on it from now on, and nothing is
+//  written on reads any more (lazy numbers are converted here), so any number of threads
+//  may read it at once without locking
+void cs_object_freeze(cs_json_obj *o);
+// used by doc.c and cache.c: destroys a tree, frozen or not
+void cs_object_destroy_frozen(cs_json_obj *o);
+
+// used by parser.c: moves o into a span node (dirty, with no span yet) and returns it, or
+//  returns o itself if it already is one or is the shared null; o is destroyed on failure
+cs_json_obj *cs_span_attach(cs_json_obj *o);
+
 char *cs_string_get_val(cs_json_obj *string);
 uint8_t cs_string_set_val(cs_json_obj *string, const char *value);
 size_t cs_string_get_len(cs_json_obj *string);
 
 double cs_number_get_val(cs_json_obj *number, uint8_t *success);
 uint8_t cs_number_set_val(cs_json_obj *number, double value);
+// success is 0 unless the number is integral and fits
+int64_t cs_number_get_int(cs_json_obj *number, uint8_t *success);
+// the literal text of a raw number (NULL for any other), exactly as it was parsed
+const char *cs_number_get_raw(cs_json_obj *number, size_t *len);
 
 uint8_t cs_bool_get_val(cs_json_obj *boolean, uint8_t *success);
 uint8_t cs_bool_set_val(cs_json_obj *boolean, uint8_t value);
@@ -82,4 +136,56 @@ uint8_t cs_array_set_val(cs_json_obj *array, uint32_t index, cs_json_obj *value)
 size_t cs_array_get_len(cs_json_obj *array);
 void cs_array_del_val(cs_json_obj *array, uint32_t index);
 
+// like the del functions, but the value is handed back (to the caller) instead of destroyed;
+//  NULL if there was none
+cs_json_obj *cs_object_take(cs_json_obj *object, const char *key);
+cs_json_obj *cs_array_take(cs_json_obj *array, uint32_t index);
+// puts value in the place of the element at index, and hands that element back
+cs_json_obj *cs_array_swap(cs_json_obj *array, uint32_t index, cs_json_obj *value);
+// inserts value before the element at index (index == length appends); O(length)
+uint8_t cs_array_insert(cs_json_obj *array, uint32_t index, cs_json_obj *value);
+
+// a deep copy: neither frozen nor tied to any input
+cs_json_obj *cs_object_clone(cs_json_obj *o);
+
+// Cursors over the members of an object and the elements of an array, in storage order
+//  (which for objects is not the input order). Each step is O(1) and starts fetching the
+//  following node. A cursor stays valid as long as its container isn't modified.
+struct cs_object_iter {
+    void *tab;          // cs_hash_tab
+    void *node;         // cs_knode, the next member to return
+    uint32_t bucket;
+    size_t remaining;
+};
+
+struct cs_array_iter {
+    void *node;         // cs_dll_node, the next element to return
+};
+
+typedef struct cs_object_iter cs_object_iter;
+typedef struct cs_array_iter cs_array_iter;
+
+// an iterator over anything but an object (or array) is simply empty
+void cs_object_iter_init(cs_object_iter *it, cs_json_obj *object);
+// the next member's key and value (either may be NULL); 0 after the last
+uint8_t cs_object_iter_next(cs_object_iter *it, const char **key, cs_json_obj **value);
+
+void cs_array_iter_init(cs_array_iter *it, cs_json_obj *array);
+// the next element, NULL after the last
+cs_json_obj *cs_array_iter_next(cs_array_iter *it);
+
+// structural hash: equal trees (see cs_object_equal) hash the same, whatever order their
+//  objects' members are in
+uint64_t cs_object_hash(cs_json_obj *obj);
+// deep equality; object members compare regardless of order, numbers by value
+uint8_t cs_object_equal(cs_json_obj *a, cs_json_obj *b);
+
+// the bytes a tree takes up: nodes, number payloads, strings, keys and the containers' tables,
+//  as requested from the pool and the allocator (their own overhead aside). Text borrowed from
+//  the input isn't counted. A parse adds up the same figure as it goes (cs_json_parser.used)
+size_t cs_object_footprint(cs_json_obj *o);
+
+// a fast, non-cryptographic 64-bit hash of len bytes
+uint64_t cs_json_hash_bytes(const void *data, size_t len);
+
 #endif
\ No newline at end of file
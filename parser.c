@@ -25,6 +25,10 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+// MAP_ANON is not part of strict C99/POSIX
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
 
 #include <stdlib.h>
 #include <string.h>
@@ -34,39 +38,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#include <limits.h>
 #include "eurysta.h"
 
-static inline void putback_(cs_json_parser *p, char c) {
-    if (p->whence == SRC_STREAM)
-        ungetc(c, p->source.stream);
-    p->position--;
-}
-
-static inline char next_(cs_json_parser *p) {
-    int ch = 0;
-    if (p->whence == SRC_STREAM) {
-        p->position++;
-        ch = fgetc(p->source.stream);
-        if (ch == EOF)
-            return '\0';
-    }
-    // SRC_STRING or SRC_MMAP
-    else {
-        if (p->position >= p->input_size)
-            return '\0';
-        ch = p->source.string[p->position++];
-    }
-    return (char)ch;
-}
-
-static inline uint8_t match_str_(cs_json_parser *p, const char *s, uint32_t l) {
-    char c = '\0', *n = (char *)s;
-    while (*n && (c = next_(p)) && c == *n++)
-        ;
-    return n - l == s;
-}
-
 // inline isdigit/isspace > dynamically linked library isdigit/isspace
 static inline uint8_t my_isdigit_(char c) {
     return c >= '0' && c <= '9';
@@ -82,351 +55,203 @@ static inline uint8_t my_isspace_(char c) {
     return s;
 }
 
-static tok_t get_tok_(cs_json_parser *p) {
-    char ch = '\0';
+extern cs_json_obj null_;
 
-    // skip whitespace
-    while (my_isspace_(ch = next_(p)))
-        ;
-    
-    switch (ch) {
-        case '[': case ']': case ':':
-        case '{': case '}': case ',':
-            return p->current = ch;
-
-        case '0': case '1': case '2': case '3':
-        case '4': case '5': case '6': case '7':
-        case '8': case '9': case '-':
-            putback_(p, ch);
-            return p->current = TOK_NUMBER;
-
-        case '"':
-            return p->current = TOK_STRING;
-        
-        // expect literal 'null'
-        case 'n':
-            if (match_str_(p, "ull", 3))
-                return p->current = TOK_NULL;
-
-            p->error = ERR_EXPECTED_NULL;
-            break;
-        
-        // expect literal 'true'
-        case 't':
-            if (match_str_(p, "rue", 3))
-                return p->current = TOK_TRUE;
-
-            p->error = ERR_EXPECTED_TRUE;
-            break;
-        
-        // expect literal 'false'
-        case 'f':
-            if (match_str_(p, "alse", 4))
-                return p->current = TOK_FALSE;
-
-            p->error = ERR_EXPECTED_FALSE;
-            break;
-        
-        case '\0':
-            return p->current = TOK_END;
-        
-        default:
-            p->error = ERR_ILLEGAL;
-            return TOK_END;
+// counts bytes the tree being built takes up against the limit
+static inline uint8_t charge_(cs_json_parser *p, size_t bytes) {
+    p->used += bytes;
+    if (p->limits.max_bytes != 0 && p->used > p->limits.max_bytes) {
+        p->error = ERR_LIMIT;
+        return 0;
     }
+    return 1;
 }
 
-// this function a hotspot -- small improvements go a long way
-static char *string_(cs_json_parser *p) {
-    uint32_t buf_size = 4096;
-    // start with a stack buffer, if more space is needed, a larger heap buffer will be allocated
-    char buf[4096];
-    char *buffer = buf;
-    
-    // "embedded" state machine
-    uint32_t len = 0;
-    uint8_t in_esc  = 0,  // in escape sequence initiated by \ (reverse solidus)
-            in_uni  = 0,  // in Unicode escape sequence initiated by \u
-            uni_len = 0;  // position in Unicode escape sequence (e.g. '\u5c5c'): 0-3 inclusive
-
-    uint16_t uni_code = 0;
-    char c = '\0';
-    while ((c = next_(p))) {
-        if (!in_esc && !in_uni) {
-            switch (c) {
-                case '"':
-                    // the unescaped final double quote--at last!
-                    goto win;
-                case '\\':
-                    // note the start of an escape sequence
-                    in_esc = 1;
-                    break;
-                default:
-                    // character is nothing special, buffer it
-                    buffer[len++] = c;
-                    break;
-            }
-        }
-        else if (in_uni) {
-            // a character in [0-9A-Fa-f] must be converted to a 4 bit integer
-            uint8_t half = 0;
-            if (my_isdigit_(c)) {
-                half = c - '0'; // 0-9
-            }
-            else if (c >= 'A' && c <= 'F') {
-                half = c - 55; // 10-15
-            }
-            else if (c >= 'a' && c <= 'f') {
-                half = c - 87; // 10-15
-            }
-            else {
-                // not /[0-9A-Fa-f]/
-                p->error = ERR_INVALID_ESCAPE;
-                goto fail;
-            }
-            
-            // pack in the latest 4 bits
-            uni_code <<= 4;
-            uni_code |= half;
-
-            // UTF-8 <3
-            if (++uni_len == 4) {
-                // just a 7-bit ASCII char, no big deal
-                if (uni_code <= 0x7F) {
-                    buffer[len++] = (char)uni_code;
-                }
-                // now we're going dual-byte
-                else if (uni_code <= 0x07FF) {                    
-                    // prefix with '110', then select the 5 most significant bits
-                    //  of the char code, shift them down and combine
-                    buffer[len++] = 0xC0 | ((uni_code & 0x07C0) >> 6);
-                    
-                    // prefix with '10', then select the 6 lowest bits of the char code and combine
-                    buffer[len++] = 0x80 | (uni_code & 0x3F);
-                    
-                    // result = 0b110xxxxx 0b10xxxxxx, where x refers to a bit of the char code
-                }
-                // and beyond...
-                else {
-                    // prefix with '1110', indicating a 4 byte sequence, select the 4 most
-                    //  significant bits of the char code, shift, etc.
-                    buffer[len++] = 0xE0 | ((uni_code & 0xF000) >> 12);
-                    
-                    // prefix with '10', followed by the next 6 most significant bits of the char code
-                    buffer[len++] = 0x80 | ((uni_code & 0x0FC0) >> 6);
-                    
-                    // same situation as with 2 byte sequences
-                    buffer[len++] = 0x80 | (uni_code & 0x3F);
-                    
-                    // result = 0b1110xxxx 0b10xxxxxx 0b10xxxxxx
-                }
-                in_uni = in_esc = uni_len = uni_code = 0;
-            }
-        }
-        else {
-            switch (c) {
-                // note the start of a Unicode escape
-                case 'u': in_uni = 1; break;
-                // single character escape sequences
-                case 'n':  buffer[len++] = '\n'; break;
-                case '"':  buffer[len++] = '"'; break;
-                case '/':  buffer[len++] = '/'; break;
-                case 'b':  buffer[len++] = '\b'; break;
-                case 'f':  buffer[len++] = '\f'; break;
-                case 'r':  buffer[len++] = '\r'; break;
-                case 't':  buffer[len++] = '\t'; break;
-                case '\\': buffer[len++] = '\\'; break;
-                default:
-                    p->error = ERR_INVALID_ESCAPE;
-                    goto fail;
-            }
-            in_esc = 0;
-        }
-        
-        // buffer must have at least 4 free bytes:
-        // potentially 3 for high Unicode sequences, and a terminating 0 byte
-        if (len > buf_size - 4) {
-            char *new = realloc((buf_size == sizeof(buf)) ? NULL : buffer, buf_size += 2048);
-            if (new == NULL) {
-                p->error = ERR_NO_MEM;
-                goto fail;
-            }
-            // buf_size equals sizeof(buf) iff buffer is on stack
-            if (buf_size == sizeof(buf)) {
-                memcpy(new, buffer, len);
-            }
-            buffer = new;
-        }
+// charges a value just built (anything but a container) to the parse
+static inline cs_json_obj *leaf_(cs_json_parser *p, cs_json_obj *o, size_t bytes) {
+    if (o != NULL && !charge_(p, bytes)) {
+        cs_object_destroy(o);
+        return NULL;
     }
-
-    char *final = NULL;
-
-// Yes, I understand that gotos and labels are "bad" -- this works
-win:
-    buffer[len++] = '\0';
-    final = malloc(len);
-    if (final != NULL)
-        memcpy(final, buffer, len);
-
-fail:
-    // free buffer unless it's on the stack
-    if (buf_size != sizeof(buf))
-        free(buffer);
-    return final;
+    return o;
 }
 
-extern cs_json_obj null_;
-
-static cs_json_obj *number_(cs_json_parser *p) {
-    char buffer[256];
-    char c = '\0';
-    uint32_t len = 0;
-
-    // "embedded" state machine makes a comeback, albeit with less grandeur
-    uint8_t in_expo = 0, // in the optional exponent part of the number (following 'e' or 'E')
-            in_frac = 0; // in the optinal fraction part of the number (folowwing '.')
-    
-    while (len < sizeof(buffer) - 1 && (c = next_(p))) {
-        switch (c) {
-            case '.':
-                if (in_frac)
-                    goto fail;
-                in_frac = 1;
-                break;
-            case 'e': case 'E':
-                if (in_expo)
-                    goto fail;
-                in_expo = 1;
-                break;
-            case '+': case '-':
-                // '+' or '-' may appear within a number iff it immediately follows 'e' or 'E'
-                if (len > 0 && (buffer[len - 1] != 'e' && buffer[len - 1] != 'E'))
-                    goto fail;
-                break;
-            default:
-                // end of the number
-                if (!my_isdigit_(c)) {
-                    putback_(p, c);
-                    goto win;
-                }
-                break;
-        }
-        buffer[len++] = c;
+// whether a string of len bytes (plus its NUL) may be kept
+static inline uint8_t string_fits_(cs_json_parser *p, size_t len) {
+    if ((p->limits.max_string != 0 && len > p->limits.max_string) ||
+        (p->limits.max_bytes != 0 && p->used + len + 1 > p->limits.max_bytes)) {
+        p->error = ERR_LIMIT;
+        return 0;
     }
+    return 1;
+}
 
-fail:
-    p->error = ERR_ILLEGAL;
-    return NULL;
-
-win:
-    buffer[len] = '\0';
+// whether strtod finds a number literal out of range (the parse makes those null). With a
+//  mantissa under 20 characters and an exponent within 280 it can't be, which spares lazy
+//  parsing the conversion for nearly every literal
+static uint8_t out_of_range_(const char *text, uint32_t len) {
+    const char *e = memchr(text, 'e', len);
+    if (e == NULL)
+        e = memchr(text, 'E', len);
+    if (e == NULL && len < 20)
+        return 0;
+    if (e != NULL && e - text < 20) {
+        const char *d = e + 1 + (e[1] == '-' || e[1] == '+');
+        uint32_t exp = 0;
+        for (; *d >= '0' && *d <= '9' && exp <= 280; d++)
+            exp = exp * 10 + (*d - '0');
+        if (exp <= 280)
+            return 0;
+    }
     errno = 0;
-    double val = strtod(buffer, NULL);
-    if (errno == ERANGE || errno == EINVAL)
-        return &null_;
-    return cs_number_create(val);
+    strtod(text, NULL);
+    return errno == ERANGE;
 }
 
-static inline cs_json_obj *do_parse_(cs_json_parser *);
-
-static cs_json_obj *array_(cs_json_parser *p) {
-    cs_json_obj *array = cs_array_create();
-    if (array == NULL) {
-        p->error = ERR_NO_MEM;
-        return NULL;
+// a number literal as an int64_t, if it is a whole number that fits: "1e3" is 1000, "1.5"
+//  and "1e19" are not integers
+static uint8_t int_value_(const char *text, int64_t *out) {
+    char *end;
+    errno = 0;
+    long long i = strtoll(text, &end, 10);
+    // plain digits are taken exactly, past the 2^53 a double holds
+    if (*end == '\0') {
+        if (errno == ERANGE)
+            return 0;
+        *out = i;
+        return 1;
     }
-    
-    do {    
-        cs_json_obj *obj = do_parse_(p);
-        if (obj == NULL) {
-            if (p->current == TOK_RSQUARE) // [ ]
-                return array;
-            // only set error if one was not assigned previously
-            if (p->error == ERR_NONE)
-                p->error = ERR_EXPECTED_VALUE;
-            goto fail;
-        }
-        
-        // success--appened object
-        cs_dll_app((cs_dll *)(array->data), obj);
+    double v = strtod(text, NULL);
+    // 2^63 is exact as a double, and (int64_t)v is only defined below it
+    if (!(v >= -9223372036854775808.0 && v < 9223372036854775808.0) || (double)(int64_t)v != v)
+        return 0;
+    *out = (int64_t)v;
+    return 1;
+}
 
-    } while (get_tok_(p) == TOK_COMMA);
-    
-    if (p->current == TOK_RSQUARE)
-        return array;
-    
-    p->error = ERR_EXPECTED_RSQUARE;
-    
-fail:
-    cs_object_destroy(array);
-    return NULL;
+// one more object or array nested in the ones being parsed; undone with p->depth--
+static inline uint8_t nest_(cs_json_parser *p) {
+    if (p->limits.max_depth != 0 && p->depth >= p->limits.max_depth) {
+        p->error = ERR_LIMIT;
+        return 0;
+    }
+    p->depth++;
+    return 1;
 }
 
-static cs_json_obj *object_(cs_json_parser *p) {
-    cs_json_obj *object = cs_object_create();
-    if (object == NULL) {
-        p->error = ERR_NO_MEM;
-        return NULL;
+// windowed mmap: drops the pages behind the parser and asks for the next window to be read
+//  ahead; called from the lexer every time position passes release_at
+static void release_parsed_(cs_json_parser *p) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    char *base = (char *)p->source.string;
+    size_t pos = (size_t)p->position;
+
+    // keep the page under the read position, putback_ may step back into it
+    size_t end = pos & ~(page - 1);
+    end = (end >= page) ? end - page : 0;
+    if (end > p->released) {
+        madvise(base + p->released, end - p->released, MADV_DONTNEED);
+        p->released = end;
     }
-    
-    do {
-        // try to match first double quote
-        if (get_tok_(p) != TOK_STRING) {
-            if (p->current == TOK_RCURLY)
-                return object;
-            p->error = ERR_EXPECTED_KEY;
-            goto fail;
-        }
 
-        char *key = string_(p);
-        if (key == NULL) {
-            goto fail;
-        }
-        
-        // try to match key-value separator :
-        if (get_tok_(p) != TOK_COLON) {
-            p->error = ERR_EXPECTED_COLON;
-            goto fail;
-        }
-        
-        cs_json_obj *val = do_parse_(p);
-        if (val == NULL) {
-            if (p->error == ERR_NONE)
-                p->error = ERR_EXPECTED_VALUE;
-            free(key);
-            goto fail;
-        }
-        
-        cs_hash_set((cs_hash_tab *)(object->data), key, val);
-        
-    } while (get_tok_(p) == TOK_COMMA);
-    
-    // match closing }
-    if (p->current == TOK_RCURLY)
-        return object;
+    size_t ahead = pos & ~(page - 1);
+    if (ahead < p->input_size) {
+        size_t len = (p->input_size - ahead < p->window) ? p->input_size - ahead : p->window;
+        madvise(base + ahead, len, MADV_WILLNEED);
+    }
 
-    p->error = ERR_EXPECTED_RCURLY;
+    p->release_at = p->position + p->window;
+}
 
-fail:
-    cs_object_destroy(object);
-    return NULL;
+// token-level code is written once, in the *_tmpl.h files, and instantiated per kind of source
+#define TMPL_CAT2_(a, b) a##b
+#define TMPL_CAT_(a, b) TMPL_CAT2_(a, b)
+#define TMPL_(name) TMPL_CAT_(name, TMPL_SUFFIX)
+
+#define TMPL_BUFFER  0
+#define TMPL_STREAM  1
+#define TMPL_CHUNKED 2
+
+// contiguous buffers (SRC_STRING, SRC_MMAP)
+#define TMPL_SUFFIX buf_
+#define TMPL_SOURCE TMPL_BUFFER
+#include "parser_tmpl.h"
+#include "bind_tmpl.h"
+#include "project_tmpl.h"
+#undef TMPL_SUFFIX
+#undef TMPL_SOURCE
+
+// FILE * streams (SRC_STREAM)
+#define TMPL_SUFFIX stm_
+#define TMPL_SOURCE TMPL_STREAM
+#include "parser_tmpl.h"
+#include "bind_tmpl.h"
+#undef TMPL_SUFFIX
+#undef TMPL_SOURCE
+
+// block-by-block sources (SRC_CHUNKED)
+#define TMPL_SUFFIX chk_
+#define TMPL_SOURCE TMPL_CHUNKED
+#include "parser_tmpl.h"
+#include "bind_tmpl.h"
+#undef TMPL_SUFFIX
+#undef TMPL_SOURCE
+
+// the lexer takes a failed read for the end of input; whatever it made of that, the
+//  input wasn't all there
+static inline uint8_t read_failed_(cs_json_parser *p) {
+    if (!p->source.chunked->failed)
+        return 0;
+    p->error = ERR_READ;
+    return 1;
 }
 
-static inline cs_json_obj *do_parse_(cs_json_parser *p) {
-    switch (get_tok_(p)) {
-        case TOK_LCURLY:  return object_(p);
-        case TOK_LSQUARE: return array_(p);
-        case TOK_NUMBER:  return number_(p);
-        case TOK_STRING:  return cs_string_create(string_(p), 1);(p);
-        case TOK_TRUE:    return cs_bool_create(1);
-        case TOK_FALSE:   return cs_bool_create(0);
-        case TOK_NULL:    return &null_;
+cs_json_obj *cs_json_parse(cs_json_parser *p) {
+    cs_json_obj *o;
+    p->used = 0;
+    p->depth = 0;
+    // the only place the source type is consulted
+    switch (p->whence) {
+        case SRC_STREAM:  return do_parse_stm_(p);
+        case SRC_CHUNKED:
+            o = do_parse_chk_(p);
+            if (read_failed_(p)) {
+                cs_object_destroy(o);
+                return NULL;
+            }
+            return o;
+        default:          return do_parse_buf_(p);
     }
-    return NULL;  
 }
 
-cs_json_obj *cs_json_parse(cs_json_parser *p) {
-    return do_parse_(p);
+uint8_t cs_json_bind(cs_json_parser *p, const cs_bind_desc *d, void *out) {
+    uint8_t ok;
+    p->used = 0;
+    p->depth = 0;
+    // not through cs_bind_init, or rejected by it
+    if (!d->ready) {
+        p->error = ERR_ILLEGAL;
+        return 0;
+    }
+    cs_bind_clear(d, out);
+    switch (p->whence) {
+        case SRC_STREAM:  return bind_stm_(p, d, out);
+        case SRC_CHUNKED:
+            ok = bind_chk_(p, d, out);
+            return !read_failed_(p) && ok;
+        default:          return bind_buf_(p, d, out);
+    }
+}
+
+size_t cs_json_project(cs_json_parser *p, cs_projection *pr, cs_json_writer *w) {
+    p->used = 0;
+    p->depth = 0;
+    // values are copied straight out of the input, which has to be in memory
+    if (p->whence != SRC_STRING && p->whence != SRC_MMAP) {
+        p->error = ERR_ILLEGAL;
+        return 0;
+    }
+    return project_buf_(p, pr, w);
 }
 
 cs_json_parser *cs_parser_create_fn(const char *file) {
@@ -435,28 +260,54 @@ cs_json_parser *cs_parser_create_fn(const char *file) {
 }
 
 cs_json_parser *cs_parser_create_fmm(const char *file) {
+    return cs_parser_create_fmm_opt(file, 0, 0);
+}
+
+cs_json_parser *cs_parser_create_fmm_opt(const char *file, uint32_t flags, size_t window) {
     cs_json_parser *p = cs_parser_create_s(NULL);
     if (p == NULL)
         return NULL;
     
     int fd = -1;
-    if ((fd = open(file, O_RDONLY)) > 0) {
+    if ((fd = open(file, O_RDONLY)) >= 0) {
         struct stat s;
-        if (fstat(fd, &s) != -1) {
-            if ((p->source.string = mmap(NULL, s.st_size, PROT_READ, MAP_SHARED, fd, 0)) != MAP_FAILED) {
-                p->file_des = fd;
-                p->input_size = s.st_size;
-                p->whence = SRC_MMAP;
-                return p;
-            }
-            else {
-                close(fd);
+        // the whole file has to fit in the address space
+        if (fstat(fd, &s) != -1 && (uint64_t)s.st_size < SIZE_MAX) {
+            // reserve one byte more than the file and lay the file over the front of it:
+            //  whatever follows the file in its last page (or the whole extra page when
+            //  the file is page-aligned) reads as zero, which gives the lexer its sentinel
+            size_t size = s.st_size;
+            char *base = mmap(NULL, size + 1, PROT_READ, MAP_PRIVATE | MAP_ANON, -1, 0);
+            if (base != MAP_FAILED) {
+                if (size == 0 || mmap(base, size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED) {
+                    p->source.string = base;
+                    p->file_des = fd;
+                    p->input_size = size;
+                    p->whence = SRC_MMAP;
+
+                    // the file is read front to back, exactly once
+                    madvise(base, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+                    if (flags & CS_MMAP_HUGE)
+                        madvise(base, size, MADV_HUGEPAGE);
+#endif
+                    if (window > 0) {
+                        p->window = window;
+                        release_parsed_(p);
+                    }
+                    else {
+                        madvise(base, size, MADV_WILLNEED);
+                    }
+                    return p;
+                }
+                munmap(base, size + 1);
             }
         }
+        close(fd);
     }
     
     // err
-    free(p);
+    cs_pool_put_parser(p);
     return NULL;
 }
 
@@ -464,7 +315,7 @@ cs_json_parser *cs_parser_create_f(FILE *source) {
     if (source == NULL)
         return NULL;
 
-    cs_json_parser *p = malloc(sizeof(cs_json_parser));
+    cs_json_parser *p = cs_pool_get_parser();
     if (p == NULL)
         return NULL;
 
@@ -472,22 +323,47 @@ cs_json_parser *cs_parser_create_f(FILE *source) {
     p->source.stream = source;
     p->position = 0;
     p->error = ERR_NONE;
+    p->options = 0;
+    p->limits = (struct cs_parse_limits){ 0 };
+    p->release_at = UINT64_MAX;
     
     return p;
 }
 
 cs_json_parser *cs_parser_create_s(const char *source) {
-    cs_json_parser *p = malloc(sizeof(cs_json_parser));
+    return cs_parser_create_sn(source, (source != NULL) ? strlen(source) : 0);
+}
+
+cs_json_parser *cs_parser_create_sn(const char *source, size_t len) {
+    cs_json_parser *p = cs_pool_get_parser();
     if (p == NULL)
         return NULL;
 
+    if (!cs_parser_init_sn(p, source, len)) {
+        cs_pool_put_parser(p);
+        return NULL;
+    }
+    
+    return p;
+}
+
+uint8_t cs_parser_init_sn(cs_json_parser *p, const char *source, size_t len) {
+    // the terminating NUL is the lexer's end-of-input sentinel
+    if (source != NULL && source[len] != '\0')
+        return 0;
+
     p->whence = SRC_STRING;
     p->source.string = source;
     p->position = 0;
-    p->input_size = UINT_MAX;
+    p->input_size = len;
     p->error = ERR_NONE;
-    
-    return p;
+    p->current = 0;
+    p->options = 0;
+    p->limits = (struct cs_parse_limits){ 0 };
+    p->release_at = UINT64_MAX;
+    p->released = p->window = 0;
+
+    return 1;
 }
 
 void cs_parser_destroy(cs_json_parser *p) {
@@ -495,10 +371,13 @@ void cs_parser_destroy(cs_json_parser *p) {
         fclose(p->source.stream);
     }
     else if (p->whence == SRC_MMAP) {
-        munmap((void *)p->source.string, p->input_size);
+        munmap((void *)p->source.string, p->input_size + 1);
         close(p->file_des);
     }
-    free(p);
+    else if (p->whence == SRC_CHUNKED) {
+        cs_chunked_destroy(p->source.chunked);
+    }
+    cs_pool_put_parser(p);
 }
 
 const char *cs_strtype(enum obj_type t) {
@@ -521,7 +400,12 @@ const char *cs_strerror(enum err_type e) {
         "Expected 'true'",
         "Expected 'false'",
         "Expected 'null'",
-        "Invalid escape"
+        "Invalid escape",
+        "Type mismatch",
+        "Path not found",
+        "Test failed",
+        "Resource limit exceeded",
+        "Could not read input"
     };
     if (e < sizeof(errors))
         return errors[e];
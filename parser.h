@@ -28,12 +28,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef CS_PARSER_H
 #define CS_PARSER_H
 
+#include <stdint.h>
 #include <sys/types.h>
+#include "bind.h"
 
 enum src_type {
     SRC_STREAM,
     SRC_STRING,
-    SRC_MMAP
+    SRC_MMAP,
+    SRC_CHUNKED
 };
 
 enum err_type {
@@ -48,7 +51,12 @@ enum err_type {
     ERR_EXPECTED_TRUE,
     ERR_EXPECTED_FALSE,
     ERR_EXPECTED_NULL,
-    ERR_INVALID_ESCAPE
+    ERR_INVALID_ESCAPE,
+    ERR_TYPE_MISMATCH,
+    ERR_NOT_FOUND,
+    ERR_TEST_FAILED,
+    ERR_LIMIT,
+    ERR_READ
 };
 
 enum tok_type {
@@ -70,34 +78,82 @@ typedef enum src_type src_t;
 typedef enum err_type err_t;
 typedef enum tok_type tok_t;
 
+// per-parse resource limits (cs_json_parser.limits); 0 means no limit. A parse stops with
+//  ERR_LIMIT as soon as one is crossed
+struct cs_parse_limits {
+    size_t max_bytes;       // memory the tree may take up, as cs_object_footprint counts it
+    size_t max_string;      // bytes in any one decoded string or key
+    size_t max_members;     // members of any one object, elements of any one array
+    uint32_t max_depth;     // objects and arrays nested in one another, skipped ones too
+                            //  (also enforced by cs_json_bind and cs_json_project)
+};
+
 struct cs_json_parser {
-    uint32_t position;
+    uint64_t position;
     union {
         FILE *stream;
         const char *string;
+        struct cs_chunked *chunked;
     } source;
     src_t whence;
     err_t error;
     tok_t current;
+    uint32_t options;   // CS_PARSE_* flags, may be changed between parses
+    struct cs_parse_limits limits;  // likewise
+    size_t used;        // what the tree built so far takes up (its cs_object_footprint)
+    uint32_t depth;
     // for mmap
     int file_des;
     size_t input_size;
+    // windowed mmap: parsed pages are dropped each time position passes release_at
+    uint64_t release_at;
+    size_t released;
+    size_t window;
 };
 
 typedef struct cs_json_parser cs_json_parser;
 
+// cs_json_parser.options
+// numbers keep their literal text and are converted on first use (see cs_number_get_raw);
+//  from a string or mmap source the text is borrowed, so the input must outlive the tree.
+//  A literal out of double's range is null either way
+#define CS_PARSE_LAZY_NUMBERS 0x01
+// every value remembers its text in the input, and the writer copies values that have not
+//  been modified since straight from there (string and mmap sources only; the input must
+//  outlive the tree)
+#define CS_PARSE_SPANS        0x02
+
 cs_json_parser *cs_parser_create_fn(const char *file);
 
 cs_json_parser *cs_parser_create_fmm(const char *file);
 
+// mmap flags
+#define CS_MMAP_HUGE 0x01   // ask for transparent huge pages, where the system supports them
+
+// like cs_parser_create_fmm; with a non-zero window, pages more than window bytes behind
+//  the parser are released as it goes, so resident memory stays bounded however big the file
+cs_json_parser *cs_parser_create_fmm_opt(const char *file, uint32_t flags, size_t window);
+
 cs_json_parser *cs_parser_create_f(FILE *source);
 
 cs_json_parser *cs_parser_create_s(const char *source);
 
+// len bytes of JSON; source[len] must be readable and '\0' (it serves as the end-of-input sentinel)
+cs_json_parser *cs_parser_create_sn(const char *source, size_t len);
+
+// points a caller-owned parser at a new buffer (same rules as cs_parser_create_sn), no allocation;
+// a parser set up this way must not be passed to cs_parser_destroy
+uint8_t cs_parser_init_sn(cs_json_parser *p, const char *source, size_t len);
+
 void cs_parser_destroy(cs_json_parser *p);
 
 cs_json_obj *cs_json_parse(cs_json_parser *p);
 
+// binds the object at the head of the input into out, as described by d (initialized with
+//  cs_bind_init, see bind.h);
+// on failure, strings bound so far still belong to the caller
+uint8_t cs_json_bind(cs_json_parser *p, const cs_bind_desc *d, void *out);
+
 const char *cs_strtype(enum obj_type t);
 const char *cs_strerror(enum err_type e);
 
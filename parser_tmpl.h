@@ -0,0 +1,714 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Lexer/parser "template", instantiated once per kind of input source by parser.c.
+// Before including this file, define:
+//   TMPL_SUFFIX  -- appended to every function name (e.g. buf_ or stm_) by TMPL_()
+//   TMPL_SOURCE  -- TMPL_BUFFER for a contiguous, NUL-terminated buffer, TMPL_STREAM for a
+//                   FILE *, TMPL_CHUNKED for a sequence of NUL-terminated blocks (see source.h)
+// Keeping the two apart means the hot loops never ask where their next byte is coming from.
+// There are deliberately no include guards.
+
+#if TMPL_SOURCE == TMPL_STREAM
+
+static inline void TMPL_(putback_)(cs_json_parser *p, char c) {
+    ungetc(c, p->source.stream);
+    p->position--;
+}
+
+static inline char TMPL_(next_)(cs_json_parser *p) {
+    int ch = getc(p->source.stream);
+    if (ch == EOF)
+        return '\0';
+    p->position++;
+    return (char)ch;
+}
+
+#elif TMPL_SOURCE == TMPL_CHUNKED
+
+// only ever called right after next_, so the byte is still in the current block
+static inline void TMPL_(putback_)(cs_json_parser *p, char c) {
+    p->source.chunked->pos--;
+    p->position--;
+}
+
+// each block ends with a NUL sentinel, just like a buffer source; only when the sentinel
+//  is reached is the next block fetched
+static inline char TMPL_(next_)(cs_json_parser *p) {
+    cs_chunked *s = p->source.chunked;
+    char c = s->block[s->pos];
+    if (c == '\0' && s->pos >= s->len) {
+        if (!cs_chunked_advance(s))
+            return '\0';
+        c = s->block[s->pos];
+    }
+    s->pos++;
+    p->position++;
+    return c;
+}
+
+#else
+
+static inline void TMPL_(putback_)(cs_json_parser *p, char c) {
+    p->position--;
+}
+
+// no bounds check: every buffer source ends with a NUL sentinel (see cs_parser_create_sn).
+// the sentinel is sticky -- once reached, every subsequent read returns it again
+static inline char TMPL_(next_)(cs_json_parser *p) {
+    char c = p->source.string[p->position];
+    p->position += (c != '\0');
+    return c;
+}
+
+#endif
+
+static inline uint8_t TMPL_(match_str_)(cs_json_parser *p, const char *s, uint32_t l) {
+    char c = '\0', *n = (char *)s;
+    while (*n && (c = TMPL_(next_)(p)) && c == *n++)
+        ;
+    return n - l == s;
+}
+
+static tok_t TMPL_(get_tok_)(cs_json_parser *p) {
+    char ch = '\0';
+
+    // skip whitespace
+    while (my_isspace_(ch = TMPL_(next_)(p)))
+        ;
+    
+    switch (ch) {
+        case '[': case ']': case ':':
+        case '{': case '}':
+            return p->current = ch;
+
+        case ',':
+#if TMPL_SOURCE == TMPL_BUFFER
+            // commas come often enough, and cheaply enough, to check the mmap window on
+            if (p->position >= p->release_at)
+                release_parsed_(p);
+#endif
+            return p->current = ch;
+
+        case '0': case '1': case '2': case '3':
+        case '4': case '5': case '6': case '7':
+        case '8': case '9': case '-':
+            TMPL_(putback_)(p, ch);
+            return p->current = TOK_NUMBER;
+
+        case '"':
+            return p->current = TOK_STRING;
+        
+        // expect literal 'null'
+        case 'n':
+            if (TMPL_(match_str_)(p, "ull", 3))
+                return p->current = TOK_NULL;
+
+            p->error = ERR_EXPECTED_NULL;
+            break;
+        
+        // expect literal 'true'
+        case 't':
+            if (TMPL_(match_str_)(p, "rue", 3))
+                return p->current = TOK_TRUE;
+
+            p->error = ERR_EXPECTED_TRUE;
+            break;
+        
+        // expect literal 'false'
+        case 'f':
+            if (TMPL_(match_str_)(p, "alse", 4))
+                return p->current = TOK_FALSE;
+
+            p->error = ERR_EXPECTED_FALSE;
+            break;
+        
+        case '\0':
+#if TMPL_SOURCE == TMPL_BUFFER
+            // a NUL before the end of the buffer is not the sentinel
+            if (p->position < p->input_size) {
+                p->error = ERR_ILLEGAL;
+                return TOK_END;
+            }
+#elif TMPL_SOURCE == TMPL_CHUNKED
+            if (!p->source.chunked->eof) {
+                p->error = ERR_ILLEGAL;
+                return TOK_END;
+            }
+#endif
+            return p->current = TOK_END;
+        
+        default:
+            p->error = ERR_ILLEGAL;
+            return TOK_END;
+    }
+    return TOK_END;
+}
+
+// this function a hotspot -- small improvements go a long way
+// decodes the rest of a string (the opening quote has been consumed) into buf; if more space
+//  is needed, a larger heap buffer will be allocated. returns whichever buffer holds the
+//  NUL-terminated result (the caller frees it if it isn't buf), or NULL on error
+static char *TMPL_(decode_)(cs_json_parser *p, char *buf, size_t buf_size, size_t *out_len) {
+    char *buffer = buf;
+    
+    // "embedded" state machine
+    size_t len = 0;
+    uint8_t in_esc  = 0,  // in escape sequence initiated by \ (reverse solidus)
+            in_uni  = 0,  // in Unicode escape sequence initiated by \u
+            uni_len = 0;  // position in Unicode escape sequence (e.g. '\u5c5c'): 0-3 inclusive
+
+    uint16_t uni_code = 0;
+    char c = '\0';
+    while ((c = TMPL_(next_)(p))) {
+        if (!in_esc && !in_uni) {
+            switch (c) {
+                case '"':
+                    // the unescaped final double quote--at last!
+                    goto win;
+                case '\\':
+                    // note the start of an escape sequence
+                    in_esc = 1;
+                    break;
+                default:
+                    // character is nothing special, buffer it
+                    buffer[len++] = c;
+                    break;
+            }
+        }
+        else if (in_uni) {
+            // a character in [0-9A-Fa-f] must be converted to a 4 bit integer
+            uint8_t half = 0;
+            if (my_isdigit_(c)) {
+                half = c - '0'; // 0-9
+            }
+            else if (c >= 'A' && c <= 'F') {
+                half = c - 55; // 10-15
+            }
+            else if (c >= 'a' && c <= 'f') {
+                half = c - 87; // 10-15
+            }
+            else {
+                // not /[0-9A-Fa-f]/
+                p->error = ERR_INVALID_ESCAPE;
+                goto fail;
+            }
+            
+            // pack in the latest 4 bits
+            uni_code <<= 4;
+            uni_code |= half;
+
+            // UTF-8 <3
+            if (++uni_len == 4) {
+                // just a 7-bit ASCII char, no big deal
+                if (uni_code <= 0x7F) {
+                    buffer[len++] = (char)uni_code;
+                }
+                // now we're going dual-byte
+                else if (uni_code <= 0x07FF) {                    
+                    // prefix with '110', then select the 5 most significant bits
+                    //  of the char code, shift them down and combine
+                    buffer[len++] = 0xC0 | ((uni_code & 0x07C0) >> 6);
+                    
+                    // prefix with '10', then select the 6 lowest bits of the char code and combine
+                    buffer[len++] = 0x80 | (uni_code & 0x3F);
+                    
+                    // result = 0b110xxxxx 0b10xxxxxx, where x refers to a bit of the char code
+                }
+                // and beyond...
+                else {
+                    // prefix with '1110', indicating a 4 byte sequence, select the 4 most
+                    //  significant bits of the char code, shift, etc.
+                    buffer[len++] = 0xE0 | ((uni_code & 0xF000) >> 12);
+                    
+                    // prefix with '10', followed by the next 6 most significant bits of the char code
+                    buffer[len++] = 0x80 | ((uni_code & 0x0FC0) >> 6);
+                    
+                    // same situation as with 2 byte sequences
+                    buffer[len++] = 0x80 | (uni_code & 0x3F);
+                    
+                    // result = 0b1110xxxx 0b10xxxxxx 0b10xxxxxx
+                }
+                in_uni = in_esc = uni_len = uni_code = 0;
+            }
+        }
+        else {
+            switch (c) {
+                // note the start of a Unicode escape
+                case 'u': in_uni = 1; break;
+                // single character escape sequences
+                case 'n':  buffer[len++] = '\n'; break;
+                case '"':  buffer[len++] = '"'; break;
+                case '/':  buffer[len++] = '/'; break;
+                case 'b':  buffer[len++] = '\b'; break;
+                case 'f':  buffer[len++] = '\f'; break;
+                case 'r':  buffer[len++] = '\r'; break;
+                case 't':  buffer[len++] = '\t'; break;
+                case '\\': buffer[len++] = '\\'; break;
+                default:
+                    p->error = ERR_INVALID_ESCAPE;
+                    goto fail;
+            }
+            in_esc = 0;
+        }
+        
+        // buffer must have at least 4 free bytes:
+        // potentially 3 for high Unicode sequences, and a terminating 0 byte
+        if (len > buf_size - 4) {
+            if (!string_fits_(p, len))
+                goto fail;
+            char *new = realloc((buffer == buf) ? NULL : buffer, buf_size + 2048);
+            if (new == NULL) {
+                p->error = ERR_NO_MEM;
+                goto fail;
+            }
+            // the stack buffer's contents have to be carried over by hand
+            if (buffer == buf) {
+                memcpy(new, buffer, len);
+            }
+            buffer = new;
+            buf_size += 2048;
+        }
+    }
+
+    // ran out of input before the closing double quote
+    p->error = ERR_ILLEGAL;
+    goto fail;
+
+// Yes, I understand that gotos and labels are "bad" -- this works
+win:
+    if (!string_fits_(p, len))
+        goto fail;
+    buffer[len] = '\0';
+    *out_len = len;
+    return buffer;
+
+fail:
+    // free buffer unless it's the caller's
+    if (buffer != buf)
+        free(buffer);
+    return NULL;
+}
+
+// the decoded string, in a block of exactly *len + 1 bytes
+static char *TMPL_(string_)(cs_json_parser *p, size_t *len) {
+    char buf[4096];
+    char *buffer = TMPL_(decode_)(p, buf, sizeof(buf), len);
+    if (buffer == NULL)
+        return NULL;
+
+    // a heap buffer already belongs to us, it only has to give back its slack
+    if (buffer != buf) {
+        char *final = realloc(buffer, *len + 1);
+        return (final != NULL) ? final : buffer;
+    }
+
+    char *final = malloc(*len + 1);
+    if (final != NULL)
+        memcpy(final, buffer, *len + 1);
+    else
+        p->error = ERR_NO_MEM;
+    return final;
+}
+
+// like decode_, but only checks the escapes; nothing is stored
+static uint8_t TMPL_(skip_string_)(cs_json_parser *p) {
+    char c = '\0';
+    while ((c = TMPL_(next_)(p))) {
+        if (c == '"')
+            return 1;
+        if (c != '\\')
+            continue;
+        switch (TMPL_(next_)(p)) {
+            case '"': case '\\': case '/': case 'b':
+            case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                for (int i = 0; i < 4; i++) {
+                    c = TMPL_(next_)(p);
+                    if (!my_isdigit_(c) && !(c >= 'A' && c <= 'F') && !(c >= 'a' && c <= 'f')) {
+                        p->error = ERR_INVALID_ESCAPE;
+                        return 0;
+                    }
+                }
+                break;
+            default:
+                p->error = ERR_INVALID_ESCAPE;
+                return 0;
+        }
+    }
+    // ran out of input before the closing double quote
+    p->error = ERR_ILLEGAL;
+    return 0;
+}
+
+// copies the text of a number into buffer (NUL-terminated) and returns its length, or 0 if it is malformed
+static uint32_t TMPL_(number_text_)(cs_json_parser *p, char *buffer, uint32_t size) {
+    char c = '\0';
+    uint32_t len = 0;
+
+    // "embedded" state machine makes a comeback, albeit with less grandeur
+    uint8_t in_expo = 0, // in the optional exponent part of the number (following 'e' or 'E')
+            in_frac = 0; // in the optinal fraction part of the number (folowwing '.')
+    
+    while (len < size - 1) {
+        switch (c = TMPL_(next_)(p)) {
+            case '.':
+                if (in_frac)
+                    goto fail;
+                in_frac = 1;
+                break;
+            case 'e': case 'E':
+                if (in_expo)
+                    goto fail;
+                in_expo = 1;
+                break;
+            case '+': case '-':
+                // '+' or '-' may appear within a number iff it immediately follows 'e' or 'E'
+                if (len > 0 && (buffer[len - 1] != 'e' && buffer[len - 1] != 'E'))
+                    goto fail;
+                break;
+            default:
+                // end of the number (the end of input is never put back)
+                if (!my_isdigit_(c)) {
+                    if (c != '\0')
+                        TMPL_(putback_)(p, c);
+                    goto win;
+                }
+                break;
+        }
+        buffer[len++] = c;
+    }
+
+fail:
+    p->error = ERR_ILLEGAL;
+    return 0;
+
+win:
+    buffer[len] = '\0';
+    return len;
+}
+
+static cs_json_obj *TMPL_(number_)(cs_json_parser *p) {
+    char buffer[256];
+#if TMPL_SOURCE == TMPL_BUFFER
+    const char *start = p->source.string + p->position;
+#endif
+    uint32_t len = TMPL_(number_text_)(p, buffer, sizeof(buffer));
+    if (len == 0)
+        return NULL;
+
+    // keep the literal, leave the conversion until (if ever) it's needed; only one that
+    //  would come out null is converted now, so the tree is the same as without the option
+    if (p->options & CS_PARSE_LAZY_NUMBERS) {
+        if (out_of_range_(buffer, len))
+            return &null_;
+#if TMPL_SOURCE == TMPL_BUFFER
+        return leaf_(p, cs_number_create_raw(start, CS_STR_BORROW), 2 * CS_POOL_NODE_SIZE);
+#else
+        return leaf_(p, cs_number_create_raw(buffer, CS_STR_COPY), 2 * CS_POOL_NODE_SIZE + len + 1);
+#endif
+    }
+
+    errno = 0;
+    double val = strtod(buffer, NULL);
+    if (errno == ERANGE || errno == EINVAL)
+        return &null_;
+    return leaf_(p, cs_number_create(val), 2 * CS_POOL_NODE_SIZE);
+}
+
+static inline cs_json_obj *TMPL_(do_parse_)(cs_json_parser *);
+
+// with CS_PARSE_SPANS a container becomes a span node before its members are parsed, so
+//  they can be linked back to it
+static inline cs_json_obj *TMPL_(container_)(cs_json_parser *p, cs_json_obj *o) {
+#if TMPL_SOURCE == TMPL_BUFFER
+    if (p->options & CS_PARSE_SPANS)
+        return cs_span_attach(o);
+#endif
+    return o;
+}
+
+static inline void TMPL_(link_)(cs_json_obj *container, cs_json_obj *member) {
+    if (member->flags & OBJ_FLAG_SPAN)
+        ((struct cs_json_span *)member)->parent = container;
+}
+
+static cs_json_obj *TMPL_(array_)(cs_json_parser *p) {
+    cs_json_obj *array = TMPL_(container_)(p, cs_array_create());
+    if (array == NULL) {
+        p->error = ERR_NO_MEM;
+        return NULL;
+    }
+    if (!charge_(p, cs_object_footprint(array)))
+        goto fail;
+    
+    do {    
+        // another element is coming, unless this is [ ]
+        if (p->limits.max_members != 0 && ((cs_dll *)array->data)->size >= p->limits.max_members) {
+            p->error = ERR_LIMIT;
+            goto fail;
+        }
+
+        cs_json_obj *obj = TMPL_(do_parse_)(p);
+        if (obj == NULL) {
+            if (p->current == TOK_RSQUARE) // [ ]
+                return array;
+            // only set error if one was not assigned previously
+            if (p->error == ERR_NONE)
+                p->error = ERR_EXPECTED_VALUE;
+            goto fail;
+        }
+        
+        // success--appened object
+        cs_dll_app((cs_dll *)(array->data), obj);
+        TMPL_(link_)(array, obj);
+        if (!charge_(p, sizeof(cs_dll_node)))
+            goto fail;
+
+    } while (TMPL_(get_tok_)(p) == TOK_COMMA);
+    
+    if (p->current == TOK_RSQUARE)
+        return array;
+    
+    p->error = ERR_EXPECTED_RSQUARE;
+    
+fail:
+    cs_object_destroy(array);
+    return NULL;
+}
+
+static cs_json_obj *TMPL_(object_)(cs_json_parser *p) {
+    cs_json_obj *object = TMPL_(container_)(p, cs_object_create());
+    if (object == NULL) {
+        p->error = ERR_NO_MEM;
+        return NULL;
+    }
+    if (!charge_(p, cs_object_footprint(object)))
+        goto fail;
+    cs_hash_tab *tab = object->data;
+    
+    do {
+        // try to match first double quote
+        if (TMPL_(get_tok_)(p) != TOK_STRING) {
+            if (p->current == TOK_RCURLY)
+                return object;
+            p->error = ERR_EXPECTED_KEY;
+            goto fail;
+        }
+
+        // another member is coming
+        if (p->limits.max_members != 0 && tab->count >= p->limits.max_members) {
+            p->error = ERR_LIMIT;
+            goto fail;
+        }
+
+        size_t key_len = 0;
+        char *key = TMPL_(string_)(p, &key_len);
+        if (key == NULL) {
+            goto fail;
+        }
+        
+        // try to match key-value separator :
+        if (TMPL_(get_tok_)(p) != TOK_COLON) {
+            p->error = ERR_EXPECTED_COLON;
+            free(key);
+            goto fail;
+        }
+        
+        cs_json_obj *val = TMPL_(do_parse_)(p);
+        if (val == NULL) {
+            if (p->error == ERR_NONE)
+                p->error = ERR_EXPECTED_VALUE;
+            free(key);
+            goto fail;
+        }
+        
+        uint32_t count = tab->count, buckets = tab->size;
+        cs_hash_set(tab, key, val);
+        TMPL_(link_)(object, val);
+        // a duplicate key replaces the member (the value it had stays counted)
+        if (tab->count != count &&
+            !charge_(p, sizeof(cs_knode) + key_len + 1 + (tab->size - buckets) * sizeof(cs_knode *)))
+            goto fail;
+        
+    } while (TMPL_(get_tok_)(p) == TOK_COMMA);
+    
+    // match closing }
+    if (p->current == TOK_RCURLY)
+        return object;
+
+    p->error = ERR_EXPECTED_RCURLY;
+
+fail:
+    cs_object_destroy(object);
+    return NULL;
+}
+
+static inline cs_json_obj *TMPL_(value_)(cs_json_parser *p, tok_t t) {
+    size_t len = 0;
+    cs_json_obj *o = NULL;
+    switch (t) {
+        case TOK_LCURLY:
+        case TOK_LSQUARE:
+            if (!nest_(p))
+                return NULL;
+            o = (t == TOK_LCURLY) ? TMPL_(object_)(p) : TMPL_(array_)(p);
+            p->depth--;
+            return o;
+        case TOK_NUMBER:  return TMPL_(number_)(p);
+        case TOK_STRING:
+            o = cs_string_create(TMPL_(string_)(p, &len), 1);
+            return leaf_(p, o, CS_POOL_NODE_SIZE + len + 1);
+        case TOK_TRUE:    return leaf_(p, cs_bool_create(1), CS_POOL_NODE_SIZE);
+        case TOK_FALSE:   return leaf_(p, cs_bool_create(0), CS_POOL_NODE_SIZE);
+        case TOK_NULL:    return &null_;
+        default:          break;
+    }
+    return NULL;  
+}
+
+#if TMPL_SOURCE == TMPL_BUFFER
+// where the text of the value that starts with token t (just returned by get_tok_) begins
+static inline uint64_t TMPL_(value_start_)(cs_json_parser *p, tok_t t) {
+    // the lexer has consumed the opening character, or the whole literal; numbers are put back
+    switch (t) {
+        case TOK_LCURLY: case TOK_LSQUARE: case TOK_STRING:
+            return p->position - 1;
+        case TOK_TRUE: case TOK_NULL:
+            return p->position - 4;
+        case TOK_FALSE:
+            return p->position - 5;
+        default:
+            return p->position;
+    }
+}
+
+// parses the value that starts with token t and records where its text lies in the input
+static cs_json_obj *TMPL_(spanned_)(cs_json_parser *p, tok_t t) {
+    uint64_t start = TMPL_(value_start_)(p, t);
+    cs_json_obj *o = TMPL_(value_)(p, t);
+    if (o == NULL || o == &null_)
+        return o;
+    // containers were made span nodes up front (and counted as such)
+    uint8_t leaf = !(o->flags & OBJ_FLAG_SPAN);
+    if ((o = cs_span_attach(o)) == NULL) {
+        p->error = ERR_NO_MEM;
+        return NULL;
+    }
+    if (leaf && !charge_(p, sizeof(struct cs_json_span) - CS_POOL_NODE_SIZE)) {
+        cs_object_destroy(o);
+        return NULL;
+    }
+
+    struct cs_json_span *s = (struct cs_json_span *)o;
+    s->start = p->source.string + start;
+    s->len = (size_t)(p->position - start);
+    o->flags &= ~OBJ_FLAG_DIRTY;
+    return o;
+}
+#endif
+
+static inline cs_json_obj *TMPL_(do_parse_)(cs_json_parser *p) {
+    tok_t t = TMPL_(get_tok_)(p);
+#if TMPL_SOURCE == TMPL_BUFFER
+    if (p->options & CS_PARSE_SPANS)
+        return TMPL_(spanned_)(p, t);
+#endif
+    return TMPL_(value_)(p, t);
+}
+
+static uint8_t TMPL_(skip_value_)(cs_json_parser *, tok_t);
+
+// the members of the container that token t opened, and its closing token
+static uint8_t TMPL_(skip_members_)(cs_json_parser *p, tok_t t) {
+    if (t == TOK_LSQUARE) {
+        if ((t = TMPL_(get_tok_)(p)) == TOK_RSQUARE) // [ ]
+            return 1;
+        for (;;) {
+            if (!TMPL_(skip_value_)(p, t))
+                return 0;
+            if (TMPL_(get_tok_)(p) != TOK_COMMA)
+                break;
+            t = TMPL_(get_tok_)(p);
+        }
+        if (p->current == TOK_RSQUARE)
+            return 1;
+        if (p->error == ERR_NONE)
+            p->error = ERR_EXPECTED_RSQUARE;
+        return 0;
+    }
+
+    do {
+        if (TMPL_(get_tok_)(p) != TOK_STRING) {
+            if (p->current == TOK_RCURLY)
+                return 1;
+            if (p->error == ERR_NONE)
+                p->error = ERR_EXPECTED_KEY;
+            return 0;
+        }
+        if (!TMPL_(skip_string_)(p))
+            return 0;
+        if (TMPL_(get_tok_)(p) != TOK_COLON) {
+            if (p->error == ERR_NONE)
+                p->error = ERR_EXPECTED_COLON;
+            return 0;
+        }
+        if (!TMPL_(skip_value_)(p, TMPL_(get_tok_)(p)))
+            return 0;
+    } while (TMPL_(get_tok_)(p) == TOK_COMMA);
+    if (p->current == TOK_RCURLY)
+        return 1;
+    if (p->error == ERR_NONE)
+        p->error = ERR_EXPECTED_RCURLY;
+    return 0;
+}
+
+// consumes the value that starts with token t, without building anything
+static uint8_t TMPL_(skip_value_)(cs_json_parser *p, tok_t t) {
+    char buffer[256];
+    uint8_t ok;
+    switch (t) {
+        case TOK_STRING:
+            return TMPL_(skip_string_)(p);
+        case TOK_NUMBER:
+            return TMPL_(number_text_)(p, buffer, sizeof(buffer)) != 0;
+        case TOK_TRUE: case TOK_FALSE: case TOK_NULL:
+            return 1;
+        case TOK_LSQUARE: case TOK_LCURLY:
+            // nothing is built, but the recursion is as deep as the nesting
+            if (!nest_(p))
+                return 0;
+            ok = TMPL_(skip_members_)(p, t);
+            p->depth--;
+            return ok;
+        default:
+            if (p->error == ERR_NONE)
+                p->error = ERR_EXPECTED_VALUE;
+            return 0;
+    }
+}
@@ -0,0 +1,578 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// strdup is POSIX, not C99
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "eurysta.h"
+
+static void tokens_free_(struct cs_patch_token *t, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        free(t[i].key);
+    free(t);
+}
+
+// "-", or a decimal number without leading zeros that fits below CS_PATCH_END
+static uint32_t index_(const char *k) {
+    if (k[0] == '-' && k[1] == '\0')
+        return CS_PATCH_END;
+    if (k[0] < '0' || k[0] > '9' || (k[0] == '0' && k[1] != '\0'))
+        return CS_PATCH_NO_INDEX;
+    uint64_t i = 0;
+    for (; *k; k++) {
+        if (*k < '0' || *k > '9' || (i = i * 10 + (*k - '0')) >= CS_PATCH_END)
+            return CS_PATCH_NO_INDEX;
+    }
+    return (uint32_t)i;
+}
+
+// splits a JSON Pointer (RFC 6901) into its tokens, unescaping "~1" and "~0";
+//  "" (the whole document) has none
+static err_t pointer_(const char *ptr, struct cs_patch_token **out, size_t *n) {
+    *out = NULL;
+    *n = 0;
+    if (ptr == NULL || (*ptr != '\0' && *ptr != '/'))
+        return ERR_ILLEGAL;
+    if (*ptr == '\0')
+        return ERR_NONE;
+
+    size_t count = 0;
+    for (const char *c = ptr; *c; c++)
+        count += (*c == '/');
+    struct cs_patch_token *t = calloc(count, sizeof(*t));
+    if (t == NULL)
+        return ERR_NO_MEM;
+
+    const char *c = ptr + 1;
+    for (size_t i = 0; i < count; i++) {
+        size_t len = strcspn(c, "/"), j = 0;
+        char *k = malloc(len + 1);
+        if (k == NULL) {
+            tokens_free_(t, i);
+            return ERR_NO_MEM;
+        }
+        for (size_t x = 0; x < len; x++) {
+            if (c[x] != '~') {
+                k[j++] = c[x];
+                continue;
+            }
+            if (c[x + 1] != '0' && c[x + 1] != '1') {
+                free(k);
+                tokens_free_(t, i);
+                return ERR_ILLEGAL;
+            }
+            k[j++] = (c[++x] == '0') ? '~' : '/';
+        }
+        k[j] = '\0';
+        t[i].key = k;
+        t[i].index = index_(k);
+        c += len + 1;
+    }
+    *out = t;
+    *n = count;
+    return ERR_NONE;
+}
+
+cs_json_patch *cs_patch_compile(cs_json_obj *ops, err_t *error) {
+    static const char *names[] = { "add", "remove", "replace", "move", "copy", "test" };
+    cs_json_patch *pt = NULL;
+    err_t e = ERR_ILLEGAL;
+    if (ops == NULL || ops->type != OBJ_TYPE_ARRAY)
+        goto fail;
+
+    e = ERR_NO_MEM;
+    size_t n = cs_array_get_len(ops);
+    if ((pt = calloc(1, sizeof(*pt))) == NULL || (pt->ops = calloc(n ? n : 1, sizeof(*pt->ops))) == NULL)
+        goto fail;
+
+    cs_array_iter it;
+    cs_json_obj *o;
+    cs_array_iter_init(&it, ops);
+    while ((o = cs_array_iter_next(&it)) != NULL) {
+        // counted right away, so that cs_patch_destroy cleans it up
+        struct cs_patch_op *op = &pt->ops[pt->count++];
+        const char *name = cs_string_get_val(cs_object_get_val(o, "op"));
+        e = ERR_ILLEGAL;
+        if (name == NULL)
+            goto fail;
+        for (op->type = CS_PATCH_ADD; op->type <= CS_PATCH_TEST && strcmp(name, names[op->type]) != 0; op->type++)
+            ;
+        if (op->type > CS_PATCH_TEST)
+            goto fail;
+
+        if ((e = pointer_(cs_string_get_val(cs_object_get_val(o, "path")), &op->path, &op->path_len)) != ERR_NONE)
+            goto fail;
+        if (op->type == CS_PATCH_MOVE || op->type == CS_PATCH_COPY) {
+            if ((e = pointer_(cs_string_get_val(cs_object_get_val(o, "from")), &op->from, &op->from_len)) != ERR_NONE)
+                goto fail;
+        }
+        if ((op->type == CS_PATCH_ADD || op->type == CS_PATCH_REPLACE || op->type == CS_PATCH_TEST) &&
+            cs_object_get_val(o, "value") == NULL) {
+            e = ERR_ILLEGAL;
+            goto fail;
+        }
+    }
+
+    // only now that the whole patch is known to be good are the values taken out of ops
+    e = ERR_NO_MEM;
+    cs_array_iter_init(&it, ops);
+    for (size_t i = 0; (o = cs_array_iter_next(&it)) != NULL; i++) {
+        struct cs_patch_op *op = &pt->ops[i];
+        if (op->type != CS_PATCH_ADD && op->type != CS_PATCH_REPLACE && op->type != CS_PATCH_TEST)
+            continue;
+        if (o->flags & OBJ_FLAG_FROZEN)
+            op->value = cs_object_clone(cs_object_get_val(o, "value"));
+        else
+            op->value = cs_object_take(o, "value");
+        if (op->value == NULL)
+            goto fail;
+    }
+    return pt;
+
+fail:
+    cs_patch_destroy(pt);
+    if (error != NULL)
+        *error = e;
+    return NULL;
+}
+
+void cs_patch_destroy(cs_json_patch *pt) {
+    if (pt == NULL)
+        return;
+    for (size_t i = 0; i < pt->count; i++) {
+        tokens_free_(pt->ops[i].path, pt->ops[i].path_len);
+        tokens_free_(pt->ops[i].from, pt->ops[i].from_len);
+        cs_object_destroy(pt->ops[i].value);
+    }
+    free(pt->ops);
+    free(pt);
+}
+
+// Every change to the tree is logged before it's made, along with whatever it needs to be
+//  undone, so undoing allocates no keys or log space. Undoing runs the log backwards.
+
+enum undo_kind_ {
+    UNDO_MEMBER_,   // an object member was set and/or removed
+    UNDO_INSERT_,   // an array element was inserted
+    UNDO_REMOVE_,   // an array element was removed
+    UNDO_SWAP_,     // an array element was replaced
+    UNDO_ROOT_      // the whole document was replaced
+};
+
+struct undo_ {
+    enum undo_kind_ kind;
+    cs_json_obj *container;
+    char *key;                  // our copy of the member's name
+    uint32_t index;
+    cs_json_obj *prev, *cur;    // what was there before and what is there now; either may be NULL
+    uint8_t drop_prev;          // prev is gone for good once the changes are kept
+    uint8_t drop_cur;           // cur was copied for the change, undoing it destroys cur
+    cs_json_obj *src;           // merge patch: the object of the patch that cur still belongs to
+};
+
+struct undo_log_ {
+    struct undo_ *e;
+    size_t count, cap;
+    cs_json_obj **root;
+};
+
+static struct undo_ *push_(struct undo_log_ *log, enum undo_kind_ kind) {
+    if (log->count == log->cap) {
+        size_t cap = (log->cap > 0) ? log->cap * 2 : 16;
+        struct undo_ *e = realloc(log->e, cap * sizeof(*e));
+        if (e == NULL)
+            return NULL;
+        log->e = e;
+        log->cap = cap;
+    }
+    struct undo_ *u = &log->e[log->count++];
+    memset(u, 0, sizeof(*u));
+    u->kind = kind;
+    return u;
+}
+
+static void undo_(struct undo_log_ *log) {
+    for (size_t i = log->count; i-- > 0;) {
+        struct undo_ *u = &log->e[i];
+        switch (u->kind) {
+            case UNDO_MEMBER_:
+                if (u->cur != NULL)
+                    cs_object_take(u->container, u->key);
+                if (u->prev != NULL) {
+                    // the table takes the key
+                    cs_object_set_val(u->container, u->key, u->prev);
+                    u->key = NULL;
+                }
+                break;
+            case UNDO_INSERT_:
+                cs_array_take(u->container, u->index);
+                break;
+            case UNDO_REMOVE_:
+                cs_array_insert(u->container, u->index, u->prev);
+                break;
+            case UNDO_SWAP_:
+                cs_array_swap(u->container, u->index, u->prev);
+                break;
+            case UNDO_ROOT_:
+                *log->root = u->prev;
+                break;
+        }
+        if (u->drop_cur)
+            cs_object_destroy(u->cur);
+        free(u->key);
+    }
+    free(log->e);
+}
+
+static void commit_(struct undo_log_ *log) {
+    for (size_t i = 0; i < log->count; i++) {
+        struct undo_ *u = &log->e[i];
+        if (u->drop_prev)
+            cs_object_destroy(u->prev);
+        // cur now belongs to the tree alone
+        if (u->src != NULL)
+            cs_object_take(u->src, u->key);
+        free(u->key);
+    }
+    free(log->e);
+}
+
+static err_t root_(struct undo_log_ *log, cs_json_obj *value, uint8_t drop) {
+    struct undo_ *u = push_(log, UNDO_ROOT_);
+    if (u == NULL)
+        return ERR_NO_MEM;
+    u->prev = *log->root;
+    u->drop_prev = 1;
+    u->cur = value;
+    u->drop_cur = drop;
+    *log->root = value;
+    return ERR_NONE;
+}
+
+// sets the member key of object to value, replacing any member already there
+static err_t member_(struct undo_log_ *log, cs_json_obj *object, const char *key, cs_json_obj *value, uint8_t drop) {
+    if (object->flags & OBJ_FLAG_FROZEN)
+        return ERR_ILLEGAL;
+    char *spare = strdup(key), *k = strdup(key);
+    struct undo_ *u = (spare != NULL && k != NULL) ? push_(log, UNDO_MEMBER_) : NULL;
+    if (u == NULL) {
+        free(spare);
+        free(k);
+        return ERR_NO_MEM;
+    }
+    u->container = object;
+    u->key = spare;
+    u->prev = cs_object_take(object, key);
+    u->drop_prev = 1;
+    if (!cs_object_set_val(object, k, value)) {
+        // logged as a plain removal, which puts prev back
+        free(k);
+        return ERR_ILLEGAL;
+    }
+    u->cur = value;
+    u->drop_cur = drop;
+    return ERR_NONE;
+}
+
+// the value at the first n tokens of path, NULL if there's none
+static cs_json_obj *resolve_(cs_json_obj *root, const struct cs_patch_token *path, size_t n) {
+    cs_json_obj *o = root;
+    for (size_t i = 0; i < n && o != NULL; i++) {
+        if (o->type == OBJ_TYPE_OBJECT)
+            o = cs_object_get_val(o, path[i].key);
+        else if (o->type == OBJ_TYPE_ARRAY && path[i].index < CS_PATCH_END)
+            o = cs_array_get_val(o, path[i].index);
+        else
+            o = NULL;
+    }
+    return o;
+}
+
+static err_t add_(struct undo_log_ *log, const struct cs_patch_token *path, size_t n, cs_json_obj *value, uint8_t drop) {
+    if (n == 0)
+        return root_(log, value, drop);
+
+    cs_json_obj *parent = resolve_(*log->root, path, n - 1);
+    const struct cs_patch_token *t = &path[n - 1];
+    if (parent == NULL)
+        return ERR_NOT_FOUND;
+    if (parent->type == OBJ_TYPE_OBJECT)
+        return member_(log, parent, t->key, value, drop);
+    if (parent->type != OBJ_TYPE_ARRAY)
+        return ERR_NOT_FOUND;
+
+    size_t len = cs_array_get_len(parent);
+    size_t i = (t->index == CS_PATCH_END) ? len : t->index;
+    if (i > len)
+        return ERR_NOT_FOUND;
+    struct undo_ *u = push_(log, UNDO_INSERT_);
+    if (u == NULL)
+        return ERR_NO_MEM;
+    if (!cs_array_insert(parent, i, value)) {
+        log->count--;
+        return (parent->flags & OBJ_FLAG_FROZEN) ? ERR_ILLEGAL : ERR_NO_MEM;
+    }
+    u->container = parent;
+    u->index = i;
+    u->cur = value;
+    u->drop_cur = drop;
+    return ERR_NONE;
+}
+
+// detaches the member or element t of parent into *out; it's destroyed when the changes
+//  are kept, unless keep is set (it's being moved)
+static err_t detach_(struct undo_log_ *log, cs_json_obj *parent, const struct cs_patch_token *t, uint8_t keep, cs_json_obj **out) {
+    if (resolve_(parent, t, 1) == NULL)
+        return ERR_NOT_FOUND;
+    if (parent->flags & OBJ_FLAG_FROZEN)
+        return ERR_ILLEGAL;
+
+    struct undo_ *u;
+    if (parent->type == OBJ_TYPE_OBJECT) {
+        char *spare = strdup(t->key);
+        if (spare == NULL || (u = push_(log, UNDO_MEMBER_)) == NULL) {
+            free(spare);
+            return ERR_NO_MEM;
+        }
+        u->key = spare;
+        u->prev = cs_object_take(parent, t->key);
+    }
+    else {
+        if ((u = push_(log, UNDO_REMOVE_)) == NULL)
+            return ERR_NO_MEM;
+        u->index = t->index;
+        u->prev = cs_array_take(parent, t->index);
+    }
+    u->container = parent;
+    u->drop_prev = !keep;
+    *out = u->prev;
+    return ERR_NONE;
+}
+
+static err_t remove_(struct undo_log_ *log, const struct cs_patch_token *path, size_t n, uint8_t keep, cs_json_obj **out) {
+    // removing the document itself leaves nothing to stand for it
+    if (n == 0)
+        return ERR_ILLEGAL;
+
+    cs_json_obj *parent = resolve_(*log->root, path, n - 1);
+    if (parent == NULL)
+        return ERR_NOT_FOUND;
+    return detach_(log, parent, &path[n - 1], keep, out);
+}
+
+static err_t replace_(struct undo_log_ *log, const struct cs_patch_token *path, size_t n, cs_json_obj *value, uint8_t drop) {
+    if (n == 0)
+        return root_(log, value, drop);
+
+    cs_json_obj *parent = resolve_(*log->root, path, n - 1);
+    const struct cs_patch_token *t = &path[n - 1];
+    if (parent == NULL || resolve_(parent, t, 1) == NULL)
+        return ERR_NOT_FOUND;
+    if (parent->type == OBJ_TYPE_OBJECT)
+        return member_(log, parent, t->key, value, drop);
+
+    struct undo_ *u = push_(log, UNDO_SWAP_);
+    if (u == NULL)
+        return ERR_NO_MEM;
+    if ((u->prev = cs_array_swap(parent, t->index, value)) == NULL) {
+        log->count--;
+        return ERR_ILLEGAL;
+    }
+    u->container = parent;
+    u->index = t->index;
+    u->drop_prev = 1;
+    u->cur = value;
+    u->drop_cur = drop;
+    return ERR_NONE;
+}
+
+// a is b, or a location inside it
+static uint8_t within_(const struct cs_patch_token *a, size_t na, const struct cs_patch_token *b, size_t nb) {
+    if (na < nb)
+        return 0;
+    for (size_t i = 0; i < nb; i++) {
+        if (strcmp(a[i].key, b[i].key) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+static err_t op_(struct undo_log_ *log, struct cs_patch_op *op, uint32_t flags) {
+    cs_json_obj *v = NULL;
+    uint8_t keep = (flags & CS_PATCH_KEEP) != 0;
+    err_t e = ERR_NONE;
+    switch (op->type) {
+        case CS_PATCH_ADD:
+        case CS_PATCH_REPLACE:
+            // without CS_PATCH_KEEP a patch can only be applied once
+            if (op->value == NULL)
+                return ERR_ILLEGAL;
+            if ((v = keep ? cs_object_clone(op->value) : op->value) == NULL)
+                return ERR_NO_MEM;
+            if (op->type == CS_PATCH_ADD)
+                e = add_(log, op->path, op->path_len, v, keep);
+            else
+                e = replace_(log, op->path, op->path_len, v, keep);
+            if (e != ERR_NONE && keep)
+                cs_object_destroy(v);
+            return e;
+        case CS_PATCH_REMOVE:
+            return remove_(log, op->path, op->path_len, 0, &v);
+        case CS_PATCH_MOVE:
+            if (within_(op->path, op->path_len, op->from, op->from_len)) {
+                // onto itself it's a no-op, into itself it's impossible
+                if (op->path_len != op->from_len)
+                    return ERR_ILLEGAL;
+                return (resolve_(*log->root, op->from, op->from_len) != NULL) ? ERR_NONE : ERR_NOT_FOUND;
+            }
+            if ((e = remove_(log, op->from, op->from_len, 1, &v)) != ERR_NONE)
+                return e;
+            return add_(log, op->path, op->path_len, v, 0);
+        case CS_PATCH_COPY:
+            if ((v = resolve_(*log->root, op->from, op->from_len)) == NULL)
+                return ERR_NOT_FOUND;
+            if ((v = cs_object_clone(v)) == NULL)
+                return ERR_NO_MEM;
+            if ((e = add_(log, op->path, op->path_len, v, 1)) != ERR_NONE)
+                cs_object_destroy(v);
+            return e;
+        case CS_PATCH_TEST:
+            if ((v = resolve_(*log->root, op->path, op->path_len)) == NULL)
+                return ERR_NOT_FOUND;
+            return cs_object_equal(v, op->value) ? ERR_NONE : ERR_TEST_FAILED;
+    }
+    return ERR_ILLEGAL;
+}
+
+err_t cs_patch_apply(cs_json_patch *pt, cs_json_obj **root, uint32_t flags, size_t *failed) {
+    struct undo_log_ log = { NULL, 0, 0, root };
+    if (pt == NULL || root == NULL || *root == NULL)
+        return ERR_ILLEGAL;
+
+    for (size_t i = 0; i < pt->count; i++) {
+        err_t e = op_(&log, &pt->ops[i], flags);
+        if (e != ERR_NONE) {
+            undo_(&log);
+            if (failed != NULL)
+                *failed = i;
+            return e;
+        }
+    }
+    commit_(&log);
+
+    // the values are the tree's now
+    if (!(flags & CS_PATCH_KEEP)) {
+        for (size_t i = 0; i < pt->count; i++) {
+            if (pt->ops[i].type == CS_PATCH_ADD || pt->ops[i].type == CS_PATCH_REPLACE)
+                pt->ops[i].value = NULL;
+        }
+    }
+    return ERR_NONE;
+}
+
+static err_t merge_(struct undo_log_ *log, cs_json_obj *target, cs_json_obj *patch, uint8_t copy) {
+    cs_object_iter it;
+    const char *key;
+    cs_json_obj *val;
+    err_t e = ERR_NONE;
+    cs_object_iter_init(&it, patch);
+    while (e == ERR_NONE && cs_object_iter_next(&it, &key, &val)) {
+        cs_json_obj *cur = cs_object_get_val(target, key);
+        if (val->type == OBJ_TYPE_NULL) {
+            // null deletes
+            if (cur != NULL)
+                e = detach_(log, target, &(struct cs_patch_token){ (char *)key, CS_PATCH_NO_INDEX }, 0, &cur);
+        }
+        else if (val->type == OBJ_TYPE_OBJECT) {
+            // merged member by member, into a new object if there's none to merge into
+            if (cur == NULL || cur->type != OBJ_TYPE_OBJECT) {
+                if ((cur = cs_object_create()) == NULL)
+                    return ERR_NO_MEM;
+                if ((e = member_(log, target, key, cur, 1)) != ERR_NONE) {
+                    cs_object_destroy(cur);
+                    return e;
+                }
+            }
+            e = merge_(log, cur, val, copy);
+        }
+        else {
+            // anything else replaces
+            cs_json_obj *v = copy ? cs_object_clone(val) : val;
+            if (v == NULL)
+                return ERR_NO_MEM;
+            if ((e = member_(log, target, key, v, copy)) != ERR_NONE && copy)
+                cs_object_destroy(v);
+            if (e == ERR_NONE && !copy)
+                log->e[log->count - 1].src = patch;
+        }
+    }
+    return e;
+}
+
+err_t cs_merge_patch(cs_json_obj **target, cs_json_obj *patch) {
+    struct undo_log_ log = { NULL, 0, 0, target };
+    if (target == NULL || patch == NULL)
+        return ERR_ILLEGAL;
+
+    uint8_t copy = (patch->flags & OBJ_FLAG_FROZEN) != 0;
+    err_t e = ERR_NONE;
+    if (patch->type != OBJ_TYPE_OBJECT) {
+        // the patch is the new document
+        cs_json_obj *v = copy ? cs_object_clone(patch) : patch;
+        if (v == NULL)
+            return ERR_NO_MEM;
+        if ((e = root_(&log, v, copy)) != ERR_NONE) {
+            if (copy)
+                cs_object_destroy(v);
+            return e;
+        }
+        commit_(&log);
+        return ERR_NONE;
+    }
+
+    if (*target == NULL || (*target)->type != OBJ_TYPE_OBJECT) {
+        cs_json_obj *o = cs_object_create();
+        if (o == NULL)
+            return ERR_NO_MEM;
+        if ((e = root_(&log, o, 1)) != ERR_NONE) {
+            cs_object_destroy(o);
+            return e;
+        }
+    }
+    if ((e = merge_(&log, *target, patch, copy)) != ERR_NONE) {
+        undo_(&log);
+        return e;
+    }
+    commit_(&log);
+    if (!copy)
+        cs_object_destroy(patch);
+    return ERR_NONE;
+}
@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_PATCH_H
+#define CS_PATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// JSON Patch (RFC 6902) and JSON Merge Patch (RFC 7386), applied in place. Either every
+//  operation takes effect or, on an error, the tree is left exactly as it was: changes are
+//  recorded as they're made and undone in reverse, nothing is copied up front.
+
+// one reference token of a JSON Pointer, unescaped
+struct cs_patch_token {
+    char *key;
+    uint32_t index;     // the token as an array index, CS_PATCH_NO_INDEX or CS_PATCH_END ("-")
+};
+
+#define CS_PATCH_NO_INDEX UINT32_MAX
+#define CS_PATCH_END      (UINT32_MAX - 1)
+
+enum cs_patch_op_type {
+    CS_PATCH_ADD,
+    CS_PATCH_REMOVE,
+    CS_PATCH_REPLACE,
+    CS_PATCH_MOVE,
+    CS_PATCH_COPY,
+    CS_PATCH_TEST
+};
+
+struct cs_patch_op {
+    enum cs_patch_op_type type;
+    struct cs_patch_token *path, *from;
+    size_t path_len, from_len;
+    cs_json_obj *value;
+};
+
+struct cs_json_patch {
+    struct cs_patch_op *ops;
+    size_t count;
+};
+
+typedef struct cs_json_patch cs_json_patch;
+
+// cs_patch_apply flags
+#define CS_PATCH_KEEP 0x01  // copy the values into the tree, so the patch can be applied again
+
+// compiles the array of operations in ops: pointers are split and unescaped once, and the
+//  values are moved out of ops (copied, if ops is frozen). NULL if ops isn't a valid patch,
+//  with *error (if not NULL) set
+cs_json_patch *cs_patch_compile(cs_json_obj *ops, err_t *error);
+
+// applies the patch to *root (which an operation on "" replaces). Without CS_PATCH_KEEP the
+//  values end up in the tree and a successful apply uses the patch up.
+// returns ERR_NONE, or the error of the first operation that failed, with its position in
+//  *failed (if not NULL); the tree is then unchanged
+err_t cs_patch_apply(cs_json_patch *pt, cs_json_obj **root, uint32_t flags, size_t *failed);
+
+void cs_patch_destroy(cs_json_patch *pt);
+
+// merges patch into *target. On success patch is used up: its values are moved into the
+//  tree and the rest of it destroyed (unless it's frozen, then values are copied and it's
+//  left alone); on an error both are unchanged
+err_t cs_merge_patch(cs_json_obj **target, cs_json_obj *patch);
+
+#endif
@@ -0,0 +1,149 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "eurysta.h"
+
+
+struct free_block_ {
+    struct free_block_ *next;
+};
+
+struct pool_ {
+    struct free_block_ *head;
+    size_t count;
+};
+
+// per thread, so there is nothing to contend for
+static __thread struct pool_ parsers_, nodes_, spans_;
+
+// shared by all threads, and may be changed while others are using their pools
+static size_t parser_limit_ = 16,
+              node_limit_   = 1 << 16;
+
+// a thread that keeps blocks has them freed when it exits
+static pthread_key_t exit_key_;
+static pthread_once_t exit_once_ = PTHREAD_ONCE_INIT;
+static uint8_t exit_key_ok_;
+static __thread uint8_t registered_;
+
+static void thread_exit_(void *v) {
+    (void)v;
+    registered_ = 0;
+    cs_pool_trim();
+}
+
+static void make_exit_key_(void) {
+    exit_key_ok_ = (pthread_key_create(&exit_key_, thread_exit_) == 0);
+}
+
+static void register_(void) {
+    pthread_once(&exit_once_, make_exit_key_);
+    // the destructor only runs for a non-NULL value
+    if (exit_key_ok_ && pthread_setspecific(exit_key_, &registered_) == 0)
+        registered_ = 1;
+}
+
+static inline void *get_(struct pool_ *pool, size_t size) {
+    struct free_block_ *b = pool->head;
+    if (b == NULL)
+        return malloc(size);
+    pool->head = b->next;
+    pool->count--;
+    return b;
+}
+
+static inline void put_(struct pool_ *pool, size_t limit, void *v) {
+    if (v == NULL)
+        return;
+    if (pool->count >= limit) {
+        free(v);
+        return;
+    }
+    if (!registered_)
+        register_();
+    struct free_block_ *b = v;
+    b->next = pool->head;
+    pool->head = b;
+    pool->count++;
+}
+
+static void drain_(struct pool_ *pool, size_t keep) {
+    while (pool->count > keep) {
+        struct free_block_ *b = pool->head;
+        pool->head = b->next;
+        pool->count--;
+        free(b);
+    }
+}
+
+void cs_pool_set_limits(size_t parsers, size_t nodes) {
+    __atomic_store_n(&parser_limit_, parsers, __ATOMIC_RELAXED);
+    __atomic_store_n(&node_limit_, nodes, __ATOMIC_RELAXED);
+    drain_(&parsers_, parsers);
+    drain_(&nodes_, nodes);
+    drain_(&spans_, nodes);
+}
+
+void cs_pool_trim(void) {
+    drain_(&parsers_, 0);
+    drain_(&nodes_, 0);
+    drain_(&spans_, 0);
+}
+
+void cs_pool_stats(size_t *parsers, size_t *nodes) {
+    if (parsers != NULL)
+        *parsers = parsers_.count;
+    if (nodes != NULL)
+        *nodes = nodes_.count + spans_.count;
+}
+
+void *cs_pool_get_node(void) {
+    return get_(&nodes_, CS_POOL_NODE_SIZE);
+}
+
+void cs_pool_put_node(void *n) {
+    put_(&nodes_, __atomic_load_n(&node_limit_, __ATOMIC_RELAXED), n);
+}
+
+// span nodes are bigger, so they get a list of their own
+void *cs_pool_get_span(void) {
+    return get_(&spans_, sizeof(struct cs_json_span));
+}
+
+void cs_pool_put_span(void *n) {
+    put_(&spans_, __atomic_load_n(&node_limit_, __ATOMIC_RELAXED), n);
+}
+
+void *cs_pool_get_parser(void) {
+    return get_(&parsers_, sizeof(cs_json_parser));
+}
+
+void cs_pool_put_parser(void *p) {
+    put_(&parsers_, __atomic_load_n(&parser_limit_, __ATOMIC_RELAXED), p);
+}
@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_POOL_H
+#define CS_POOL_H
+
+#include <stddef.h>
+
+// Recycling of the fixed-size blocks every parse allocates: value nodes (cs_json_obj and
+//  number payloads) and parser contexts. Blocks released by cs_object_destroy and
+//  cs_parser_destroy are kept on per-thread free lists, up to a high-water mark, and handed
+//  out again by the create functions instead of going back to the system allocator.
+// Every block is still an ordinary malloc'd block, so releasing one with free() stays legal.
+
+// sets the high-water marks, which apply to each thread's lists -- blocks released beyond
+//  them are free()d. Safe to call while other threads run; only the caller's lists are
+//  drained right away, the others' shrink as they release blocks
+void cs_pool_set_limits(size_t parsers, size_t nodes);
+
+// returns the calling thread's retained blocks to the system allocator, e.g. after a burst.
+//  A thread's blocks are also given back when it exits (through pthread_exit or by returning
+//  from its start routine)
+void cs_pool_trim(void);
+
+// number of blocks the calling thread currently retains (span nodes count as nodes)
+void cs_pool_stats(size_t *parsers, size_t *nodes);
+
+// a node block holds either a cs_json_obj or a number payload
+#define CS_POOL_NODE_SIZE (sizeof(cs_json_obj) > sizeof(struct cs_number_raw) ? sizeof(cs_json_obj) : sizeof(struct cs_number_raw))
+
+// used by object.c and parser.c
+void *cs_pool_get_node(void);
+void cs_pool_put_node(void *n);
+void *cs_pool_get_span(void);
+void cs_pool_put_span(void *n);
+void *cs_pool_get_parser(void);
+void cs_pool_put_parser(void *p);
+
+#endif
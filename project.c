@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// strdup is POSIX rather than C99
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "eurysta.h"
+
+cs_projection *cs_projection_create(void) {
+    cs_projection *pr = calloc(1, sizeof(cs_projection));
+    if (pr != NULL)
+        pr->root.slot = -1;
+    return pr;
+}
+
+const struct cs_proj_node *cs_proj_find(const struct cs_proj_node *node, const char *name, size_t len) {
+    uint32_t hash = cs_bind_hash(name, len);
+    for (const struct cs_proj_node *c = node->children; c != NULL; c = c->next) {
+        if (c->hash == hash && c->len == len && memcmp(c->name, name, len) == 0)
+            return c;
+    }
+    return NULL;
+}
+
+// the slot path ends in, created (along with the path's trie nodes) if needed; -1 on error
+static int32_t slot_(cs_projection *pr, const char *path) {
+    struct cs_proj_node *node = &pr->root;
+    const char *s = path;
+
+    for (;;) {
+        size_t len = strcspn(s, ".");
+        if (len == 0)
+            return -1;
+
+        struct cs_proj_node *c = (struct cs_proj_node *)cs_proj_find(node, s, len);
+        if (c == NULL) {
+            if ((c = calloc(1, sizeof(struct cs_proj_node))) == NULL)
+                return -1;
+            if ((c->name = malloc(len + 1)) == NULL) {
+                free(c);
+                return -1;
+            }
+            memcpy(c->name, s, len);
+            c->name[len] = '\0';
+            c->len = (uint32_t)len;
+            c->hash = cs_bind_hash(s, len);
+            c->slot = -1;
+            c->next = node->children;
+            node->children = c;
+        }
+        node = c;
+
+        if (s[len] == '\0')
+            break;
+        s += len + 1;
+    }
+
+    if (node->slot < 0) {
+        struct cs_proj_span *spans = realloc(pr->spans, (pr->slots + 1) * sizeof(struct cs_proj_span));
+        if (spans == NULL)
+            return -1;
+        pr->spans = spans;
+        node->slot = (int32_t)pr->slots++;
+    }
+    return node->slot;
+}
+
+uint8_t cs_projection_add(cs_projection *pr, const char *path) {
+    int32_t slot = slot_(pr, path);
+    if (slot < 0)
+        return 0;
+
+    struct cs_proj_out *outs = realloc(pr->outs, (pr->out_count + 1) * sizeof(struct cs_proj_out));
+    if (outs == NULL)
+        return 0;
+    pr->outs = outs;
+    if ((outs[pr->out_count].path = strdup(path)) == NULL)
+        return 0;
+    outs[pr->out_count++].slot = (uint32_t)slot;
+    return 1;
+}
+
+uint8_t cs_projection_where(cs_projection *pr, const char *path, const char *value, uint8_t negate) {
+    int32_t slot = slot_(pr, path);
+    if (slot < 0)
+        return 0;
+
+    struct cs_proj_cond *conds = realloc(pr->conds, (pr->cond_count + 1) * sizeof(struct cs_proj_cond));
+    if (conds == NULL)
+        return 0;
+    pr->conds = conds;
+    struct cs_proj_cond *c = &conds[pr->cond_count];
+    if ((c->value = strdup(value)) == NULL)
+        return 0;
+    c->len = strlen(value);
+    c->slot = (uint32_t)slot;
+    c->negate = negate;
+    pr->cond_count++;
+    return 1;
+}
+
+static void free_nodes_(struct cs_proj_node *n) {
+    while (n != NULL) {
+        struct cs_proj_node *next = n->next;
+        free_nodes_(n->children);
+        free(n->name);
+        free(n);
+        n = next;
+    }
+}
+
+void cs_projection_destroy(cs_projection *pr) {
+    free_nodes_(pr->root.children);
+    for (size_t i = 0; i < pr->out_count; i++)
+        free(pr->outs[i].path);
+    for (size_t i = 0; i < pr->cond_count; i++)
+        free(pr->conds[i].value);
+    free(pr->outs);
+    free(pr->conds);
+    free(pr->spans);
+    free(pr);
+}
@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_PROJECT_H
+#define CS_PROJECT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Field projection: pulls a few fields out of every record of a large input (newline
+//  delimited JSON, or the elements of one big top-level array) straight from the token
+//  stream. No tree is built; the selected values are copied to the output byte for byte.
+// A path names nested object members with dots: "user.id". Members are matched on their
+//  text as it appears in the input, escapes and all.
+
+// one component of a compiled path; siblings are chained, the paths form a trie
+struct cs_proj_node {
+    char *name;
+    uint32_t len;
+    uint32_t hash;              // cs_bind_hash
+    int32_t slot;               // where the value is recorded, -1 unless a path ends here
+    struct cs_proj_node *children;
+    struct cs_proj_node *next;
+};
+
+struct cs_proj_out {
+    char *path;                 // also the output key
+    uint32_t slot;
+};
+
+// a record is kept only if the text of the value at slot is (or, negated, isn't) value
+struct cs_proj_cond {
+    uint32_t slot;
+    char *value;
+    size_t len;
+    uint8_t negate;
+};
+
+// the text of a value found in the current record
+struct cs_proj_span {
+    const char *start;          // NULL when the record doesn't have it
+    size_t len;
+};
+
+struct cs_projection {
+    struct cs_proj_node root;
+    struct cs_proj_out *outs;
+    size_t out_count;
+    struct cs_proj_cond *conds;
+    size_t cond_count;
+    struct cs_proj_span *spans; // per slot; scratch for the record being scanned
+    uint32_t slots;
+};
+
+typedef struct cs_projection cs_projection;
+
+cs_projection *cs_projection_create(void);
+
+// adds a field to the output; fields are written in the order they were added
+uint8_t cs_projection_add(cs_projection *pr, const char *path);
+
+// keeps only the records whose value at path is the JSON text value, e.g. "\"click\"" or
+//  "200" (compared as text, so 2e2 is not 200); with negate, only those where it isn't
+uint8_t cs_projection_where(cs_projection *pr, const char *path, const char *value, uint8_t negate);
+
+void cs_projection_destroy(cs_projection *pr);
+
+// used by parser.c
+const struct cs_proj_node *cs_proj_find(const struct cs_proj_node *node, const char *name, size_t len);
+
+// scans every record p has (p must read from a string or a file mapped into memory) and
+//  writes each one that passes the conditions to w as an object of the projected fields,
+//  followed by a newline. returns the number of records written; p->error tells whether
+//  all of the input was read. A projection can only be used by one thread at a time
+size_t cs_json_project(cs_json_parser *p, cs_projection *pr, cs_json_writer *w);
+
+#endif
@@ -0,0 +1,141 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Token-level half of field projection (see project.h); instantiated by parser.c for
+//  contiguous buffers only, since values are copied out of the input. There are
+//  deliberately no include guards.
+
+static uint8_t TMPL_(project_object_)(cs_json_parser *, const struct cs_proj_node *, struct cs_proj_span *);
+
+static uint8_t TMPL_(project_members_)(cs_json_parser *p, const struct cs_proj_node *node, struct cs_proj_span *spans) {
+    do {
+        if (TMPL_(get_tok_)(p) != TOK_STRING) {
+            if (p->current == TOK_RCURLY)
+                return 1;
+            if (p->error == ERR_NONE)
+                p->error = ERR_EXPECTED_KEY;
+            return 0;
+        }
+
+        // keys are compared as they are in the input, nothing is decoded
+        uint64_t key = p->position;
+        if (!TMPL_(skip_string_)(p))
+            return 0;
+        const struct cs_proj_node *c = cs_proj_find(node, p->source.string + key, p->position - 1 - key);
+
+        if (TMPL_(get_tok_)(p) != TOK_COLON) {
+            p->error = ERR_EXPECTED_COLON;
+            return 0;
+        }
+
+        tok_t t = TMPL_(get_tok_)(p);
+        uint64_t start = TMPL_(value_start_)(p, t);
+        uint8_t ok = (c != NULL && c->children != NULL && t == TOK_LCURLY) ?
+            TMPL_(project_object_)(p, c, spans) : TMPL_(skip_value_)(p, t);
+        if (!ok)
+            return 0;
+
+        if (c != NULL && c->slot >= 0) {
+            spans[c->slot].start = p->source.string + start;
+            spans[c->slot].len = (size_t)(p->position - start);
+        }
+
+    } while (TMPL_(get_tok_)(p) == TOK_COMMA);
+
+    if (p->current == TOK_RCURLY)
+        return 1;
+
+    p->error = ERR_EXPECTED_RCURLY;
+    return 0;
+}
+
+// the opening { has been consumed; records the spans of node's leaves found below it
+static uint8_t TMPL_(project_object_)(cs_json_parser *p, const struct cs_proj_node *node, struct cs_proj_span *spans) {
+    if (!nest_(p))
+        return 0;
+    uint8_t ok = TMPL_(project_members_)(p, node, spans);
+    p->depth--;
+    return ok;
+}
+
+// one record, starting with token t; returns 0 on error
+static uint8_t TMPL_(project_record_)(cs_json_parser *p, cs_projection *pr, cs_json_writer *w, tok_t t, size_t *kept) {
+    memset(pr->spans, 0, pr->slots * sizeof(struct cs_proj_span));
+    // a record that isn't an object has none of the fields
+    if (!(t == TOK_LCURLY ? TMPL_(project_object_)(p, &pr->root, pr->spans) : TMPL_(skip_value_)(p, t)))
+        return 0;
+
+    for (size_t i = 0; i < pr->cond_count; i++) {
+        const struct cs_proj_cond *c = &pr->conds[i];
+        const struct cs_proj_span *s = &pr->spans[c->slot];
+        uint8_t equal = (s->start != NULL && s->len == c->len && memcmp(s->start, c->value, c->len) == 0);
+        if (equal == c->negate)
+            return 1;
+    }
+
+    cs_writer_begin_object(w);
+    for (size_t i = 0; i < pr->out_count; i++) {
+        const struct cs_proj_span *s = &pr->spans[pr->outs[i].slot];
+        if (s->start == NULL)
+            continue;
+        cs_writer_key(w, pr->outs[i].path);
+        cs_writer_raw(w, s->start, s->len);
+    }
+    cs_writer_end_object(w);
+    cs_writer_raw(w, "\n", 1);
+    (*kept)++;
+    return 1;
+}
+
+static size_t TMPL_(project_)(cs_json_parser *p, cs_projection *pr, cs_json_writer *w) {
+    size_t kept = 0;
+    tok_t t = TMPL_(get_tok_)(p);
+
+    // one big array: its elements are the records
+    if (t == TOK_LSQUARE) {
+        if ((t = TMPL_(get_tok_)(p)) == TOK_RSQUARE)
+            return 0;
+        for (;;) {
+            if (!TMPL_(project_record_)(p, pr, w, t, &kept))
+                return kept;
+            if (TMPL_(get_tok_)(p) != TOK_COMMA)
+                break;
+            t = TMPL_(get_tok_)(p);
+        }
+        if (p->current != TOK_RSQUARE && p->error == ERR_NONE)
+            p->error = ERR_EXPECTED_RSQUARE;
+        return kept;
+    }
+
+    // otherwise a sequence of values, one per line
+    while (t != TOK_END) {
+        if (!TMPL_(project_record_)(p, pr, w, t, &kept))
+            return kept;
+        t = TMPL_(get_tok_)(p);
+    }
+    return kept;
+}
@@ -0,0 +1,558 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// fileno, dup, pread and posix_fadvise are POSIX rather than C99
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef CS_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CS_WITH_ZSTD
+#include <zstd.h>
+#endif
+#include "eurysta.h"
+
+// default read-ahead depth: one block being lexed, two being filled ahead of it
+#define RING_SLOTS 3
+
+// where an exhausted source parks its read position
+static const char empty_[1] = { '\0' };
+
+// Single-producer/single-consumer ring. Blocks are handed over by publishing head and tail
+//  atomically; the mutex and condition are only touched when one side actually has to sleep
+//  (ring full or empty), and the other side only signals when it sees the sleeper's flag.
+struct chunk_ring_ {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t slots;
+    char **blocks;
+    size_t *lens;
+    size_t head;            // blocks released by the lexer, written by the lexer only
+    size_t tail;            // blocks filled by the thread, written by the thread only
+    uint8_t holding;        // the lexer holds blocks[head % slots]
+    uint8_t done;           // the fill function reported the end of input
+    uint8_t failed;         // with a read error
+    uint8_t stop;           // the parser is being destroyed
+    uint8_t fill_waiting;   // the thread is asleep waiting for a free slot
+    uint8_t lex_waiting;    // the lexer is asleep waiting for a full one
+};
+
+#define LOAD_(v) __atomic_load_n(&(v), __ATOMIC_SEQ_CST)
+#define STORE_(v, x) __atomic_store_n(&(v), (x), __ATOMIC_SEQ_CST)
+
+// wakes the other side, if (and only if) it has gone to sleep
+static void wake_(struct chunk_ring_ *r, uint8_t *waiting) {
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&r->lock);
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->lock);
+    }
+}
+
+static void *ring_fill_(void *arg) {
+    cs_chunked *s = arg;
+    struct chunk_ring_ *r = s->ring;
+
+    for (;;) {
+        size_t tail = r->tail;
+        if (tail - LOAD_(r->head) >= r->slots) {
+            pthread_mutex_lock(&r->lock);
+            STORE_(r->fill_waiting, 1);
+            while (tail - LOAD_(r->head) >= r->slots && !LOAD_(r->stop))
+                pthread_cond_wait(&r->cond, &r->lock);
+            STORE_(r->fill_waiting, 0);
+            pthread_mutex_unlock(&r->lock);
+        }
+        if (LOAD_(r->stop))
+            break;
+
+        // the slot is ours until tail moves past it
+        size_t slot = tail % r->slots;
+        size_t n = s->fill(s->ctx, r->blocks[slot], s->block_size);
+        if (n == 0 || n == CS_FILL_ERROR) {
+            STORE_(r->failed, n == CS_FILL_ERROR);
+            STORE_(r->done, 1);
+            wake_(r, &r->lex_waiting);
+            break;
+        }
+        r->blocks[slot][n] = '\0';
+        r->lens[slot] = n;
+        STORE_(r->tail, tail + 1);
+        wake_(r, &r->lex_waiting);
+    }
+    return NULL;
+}
+
+static uint8_t ring_advance_(cs_chunked *s) {
+    struct chunk_ring_ *r = s->ring;
+
+    // hand the finished block back
+    if (r->holding) {
+        STORE_(r->head, r->head + 1);
+        r->holding = 0;
+        wake_(r, &r->fill_waiting);
+    }
+
+    size_t head = r->head;
+    if (LOAD_(r->tail) == head) {
+        pthread_mutex_lock(&r->lock);
+        STORE_(r->lex_waiting, 1);
+        while (LOAD_(r->tail) == head && !LOAD_(r->done))
+            pthread_cond_wait(&r->cond, &r->lock);
+        STORE_(r->lex_waiting, 0);
+        pthread_mutex_unlock(&r->lock);
+    }
+    if (LOAD_(r->tail) == head) {
+        s->failed = LOAD_(r->failed);
+        return 0;
+    }
+
+    size_t slot = head % r->slots;
+    s->block = r->blocks[slot];
+    s->len = r->lens[slot];
+    r->holding = 1;
+    return 1;
+}
+
+uint8_t cs_chunked_advance(cs_chunked *s) {
+    if (s->eof)
+        return 0;
+
+    uint8_t got = 0;
+    if (s->ring != NULL) {
+        got = ring_advance_(s);
+    }
+    else {
+        s->block = s->buffer;
+        s->len = s->fill(s->ctx, s->block, s->block_size);
+        if (s->len == CS_FILL_ERROR) {
+            s->failed = 1;
+            s->len = 0;
+        }
+        s->block[s->len] = '\0';
+        got = s->len > 0;
+    }
+
+    s->pos = 0;
+    if (!got) {
+        // park on an empty block so the sentinel keeps being returned
+        s->block = (char *)empty_;
+        s->len = 0;
+        s->eof = 1;
+    }
+    return got;
+}
+
+static void ring_free_(struct chunk_ring_ *r) {
+    if (r->blocks != NULL) {
+        for (uint32_t i = 0; i < r->slots; i++)
+            free(r->blocks[i]);
+    }
+    free(r->blocks);
+    free(r->lens);
+    free(r);
+}
+
+static uint8_t ring_start_(cs_chunked *s, uint32_t slots) {
+    struct chunk_ring_ *r = calloc(1, sizeof(struct chunk_ring_));
+    if (r == NULL)
+        return 0;
+
+    r->slots = slots;
+    if ((r->blocks = calloc(slots, sizeof(char *))) == NULL || (r->lens = calloc(slots, sizeof(size_t))) == NULL)
+        goto fail;
+    for (uint32_t i = 0; i < slots; i++) {
+        if ((r->blocks[i] = malloc(s->block_size + 1)) == NULL)
+            goto fail;
+    }
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    s->ring = r;
+    if (pthread_create(&r->thread, NULL, ring_fill_, s) != 0) {
+        pthread_mutex_destroy(&r->lock);
+        pthread_cond_destroy(&r->cond);
+        s->ring = NULL;
+        goto fail;
+    }
+    return 1;
+
+fail:
+    ring_free_(r);
+    return 0;
+}
+
+void cs_chunked_destroy(cs_chunked *s) {
+    struct chunk_ring_ *r = s->ring;
+    if (r != NULL) {
+        pthread_mutex_lock(&r->lock);
+        STORE_(r->stop, 1);
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->lock);
+        // the thread may be blocked in fill rather than waiting on cond
+        if (s->cancel != NULL)
+            s->cancel(s->ctx);
+        pthread_join(r->thread, NULL);
+
+        pthread_mutex_destroy(&r->lock);
+        pthread_cond_destroy(&r->cond);
+        ring_free_(r);
+    }
+    free(s->buffer);
+
+    if (s->close != NULL)
+        s->close(s->ctx);
+    free(s);
+}
+
+// slots == 0: no thread, blocks are filled on demand by the parsing thread
+static cs_json_parser *chunked_create_(cs_fill_fn fill, cs_close_fn close, cs_cancel_fn cancel, void *ctx, size_t block_size, uint32_t slots) {
+    if (fill == NULL)
+        return NULL;
+
+    cs_chunked *s = calloc(1, sizeof(cs_chunked));
+    if (s == NULL)
+        return NULL;
+    s->fill = fill;
+    s->cancel = cancel;
+    s->ctx = ctx;
+    s->block_size = (block_size > 0) ? block_size : CS_CHUNK_SIZE;
+
+    // start out at the end of an empty block so the first read fetches a real one
+    s->block = (char *)empty_;
+
+    if (slots > 0) {
+        if (!ring_start_(s, slots))
+            goto fail;
+    }
+    else {
+        if ((s->buffer = malloc(s->block_size + 1)) == NULL)
+            goto fail;
+    }
+
+    cs_json_parser *p = cs_pool_get_parser();
+    if (p == NULL) {
+        // don't close ctx here, the caller still owns it
+        cs_chunked_destroy(s);
+        return NULL;
+    }
+    p->whence = SRC_CHUNKED;
+    p->source.chunked = s;
+    p->position = 0;
+    p->input_size = 0;
+    p->error = ERR_NONE;
+    p->current = 0;
+    p->options = 0;
+    p->limits = (struct cs_parse_limits){ 0 };
+    p->release_at = UINT64_MAX;
+
+    // only now does ctx become ours
+    s->close = close;
+    return p;
+
+fail:
+    free(s);
+    return NULL;
+}
+
+cs_json_parser *cs_parser_create_chunked(cs_fill_fn fill, cs_close_fn close, void *ctx, size_t block_size, uint32_t flags) {
+    return chunked_create_(fill, close, NULL, ctx, block_size, (flags & CS_CHUNK_THREADED) ? RING_SLOTS : 0);
+}
+
+struct fd_src_ {
+    int fd;
+    uint8_t seekable;
+    uint64_t offset;
+    int wake[2];        // a pipe's read is interrupted by writing to wake[1]; -1 for files
+};
+
+// whether fd can be read without blocking, or the read was cancelled instead
+static uint8_t wait_readable_(struct fd_src_ *f) {
+    struct pollfd fds[2] = { { f->fd, POLLIN, 0 }, { f->wake[0], POLLIN, 0 } };
+    for (;;) {
+        if (poll(fds, 2, -1) >= 0)
+            return !(fds[1].revents & POLLIN);
+        if (errno != EINTR)
+            return 1;   // let read report it
+    }
+}
+
+// fills whole blocks: a pipe hands out a few KB at a time, which would make for tiny blocks
+static size_t fill_fd_(void *ctx, char *buf, size_t cap) {
+    struct fd_src_ *f = ctx;
+    size_t got = 0;
+    while (got < cap) {
+        if (!f->seekable && !wait_readable_(f))
+            break;
+        ssize_t n = f->seekable ? pread(f->fd, buf + got, cap - got, (off_t)f->offset)
+                                : read(f->fd, buf + got, cap - got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        // what was read before the error is still good; the next fill reports it
+        if (n < 0)
+            return (got > 0) ? got : CS_FILL_ERROR;
+        if (n == 0)
+            break;
+        got += n;
+        f->offset += n;
+    }
+    return got;
+}
+
+static void cancel_fd_(void *ctx) {
+    struct fd_src_ *f = ctx;
+    char c = 0;
+    // the pipe is never read from, so one byte keeps it readable for good
+    while (write(f->wake[1], &c, 1) < 0 && errno == EINTR)
+        ;
+}
+
+static void free_fd_(struct fd_src_ *f) {
+    if (f->wake[0] >= 0) {
+        close(f->wake[0]);
+        close(f->wake[1]);
+    }
+    free(f);
+}
+
+static void close_fd_(void *ctx) {
+    struct fd_src_ *f = ctx;
+    if (f->fd != STDIN_FILENO)
+        close(f->fd);
+    free_fd_(f);
+}
+
+cs_json_parser *cs_parser_create_rafd(int fd, size_t block_size, uint32_t slots) {
+    if (fd < 0)
+        return NULL;
+
+    struct fd_src_ *f = malloc(sizeof(struct fd_src_));
+    if (f == NULL)
+        return NULL;
+    f->fd = fd;
+    f->offset = 0;
+    f->wake[0] = f->wake[1] = -1;
+
+    // regular files are read with pread from wherever the descriptor was; pipes with read
+    struct stat st;
+    off_t at = lseek(fd, 0, SEEK_CUR);
+    f->seekable = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && at != (off_t)-1;
+    if (f->seekable) {
+        f->offset = at;
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+    // a read from a pipe may never return on its own
+    else if (pipe(f->wake) != 0) {
+        free(f);
+        return NULL;
+    }
+
+    // at least double buffering, or there is nothing to overlap
+    if (slots == 0)
+        slots = RING_SLOTS;
+    else if (slots < 2)
+        slots = 2;
+
+    cs_json_parser *p = chunked_create_(fill_fd_, close_fd_, f->seekable ? NULL : cancel_fd_, f,
+                                        (block_size > 0) ? block_size : CS_RA_BLOCK_SIZE, slots);
+    if (p == NULL)
+        free_fd_(f);
+    return p;
+}
+
+cs_json_parser *cs_parser_create_ra(const char *file, size_t block_size, uint32_t slots) {
+    int fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    cs_json_parser *p = cs_parser_create_rafd(fd, block_size, slots);
+    if (p == NULL)
+        close(fd);
+    return p;
+}
+
+static size_t fill_file_(void *ctx, char *buf, size_t cap) {
+    size_t n = fread(buf, 1, cap, (FILE *)ctx);
+    return (n == 0 && ferror((FILE *)ctx)) ? CS_FILL_ERROR : n;
+}
+
+static void close_file_(void *ctx) {
+    fclose((FILE *)ctx);
+}
+
+#ifdef CS_WITH_ZLIB
+
+static size_t fill_gz_(void *ctx, char *buf, size_t cap) {
+    // gzread takes an unsigned count
+    int n = gzread((gzFile)ctx, buf, (cap > (1u << 30)) ? (1u << 30) : (unsigned)cap);
+    return (n >= 0) ? (size_t)n : CS_FILL_ERROR;
+}
+
+static void close_gz_(void *ctx) {
+    gzclose((gzFile)ctx);
+}
+
+#endif
+
+#ifdef CS_WITH_ZSTD
+
+struct zstd_src_ {
+    FILE *file;
+    ZSTD_DStream *stream;
+    ZSTD_inBuffer in;
+    size_t in_cap;
+    size_t left;            // ZSTD_decompressStream's last word on the frame: 0 once it is complete
+    uint8_t eof;            // the file has been read to the end
+    uint8_t failed;         // reported by the next fill, after the output before it
+    char in_buf[];
+};
+
+static size_t fill_zstd_(void *ctx, char *buf, size_t cap) {
+    struct zstd_src_ *z = ctx;
+    ZSTD_outBuffer out = { buf, cap, 0 };
+
+    while (out.pos < out.size && !z->failed) {
+        if (z->in.pos == z->in.size && !z->eof) {
+            z->in.size = fread(z->in_buf, 1, z->in_cap, z->file);
+            z->in.pos = 0;
+            if (z->in.size == 0) {
+                if (ferror(z->file)) {
+                    z->failed = 1;
+                    break;
+                }
+                z->eof = 1;
+            }
+        }
+        // a corrupt frame is a read error: cut short, the input may still look like JSON
+        size_t out_before = out.pos, in_before = z->in.pos;
+        size_t left = ZSTD_decompressStream(z->stream, &out, &z->in);
+        if (ZSTD_isError(left)) {
+            z->failed = 1;
+            break;
+        }
+        // at the end of the file, once the decoder has nothing more to flush, the last
+        //  frame has to be complete
+        if (out.pos == out_before && z->in.pos == in_before) {
+            if (z->eof) {
+                z->failed = (z->left != 0);
+                break;
+            }
+            continue;
+        }
+        z->left = left;
+    }
+    if (out.pos == 0 && z->failed)
+        return CS_FILL_ERROR;
+    return out.pos;
+}
+
+static void close_zstd_(void *ctx) {
+    struct zstd_src_ *z = ctx;
+    ZSTD_freeDStream(z->stream);
+    fclose(z->file);
+    free(z);
+}
+
+static struct zstd_src_ *open_zstd_(FILE *f) {
+    size_t cap = ZSTD_DStreamInSize();
+    struct zstd_src_ *z = malloc(sizeof(struct zstd_src_) + cap);
+    if (z == NULL)
+        return NULL;
+    if ((z->stream = ZSTD_createDStream()) == NULL) {
+        free(z);
+        return NULL;
+    }
+    ZSTD_initDStream(z->stream);
+    z->file = f;
+    z->in_cap = cap;
+    z->in.src = z->in_buf;
+    z->in.size = z->in.pos = 0;
+    z->left = 0;
+    z->eof = z->failed = 0;
+    return z;
+}
+
+#endif
+
+cs_json_parser *cs_parser_create_z(const char *file, uint32_t flags) {
+    FILE *f = fopen(file, "rb");
+    if (f == NULL)
+        return NULL;
+
+    unsigned char magic[4] = { 0 };
+    size_t got = fread(magic, 1, sizeof(magic), f);
+    rewind(f);
+
+    cs_json_parser *p = NULL;
+    if (got >= 2 && magic[0] == 0x1F && magic[1] == 0x8B) {
+#ifdef CS_WITH_ZLIB
+        int fd = dup(fileno(f));
+        gzFile gz = (fd >= 0) ? gzdopen(fd, "rb") : NULL;
+        if (gz != NULL) {
+            // gz has its own descriptor now
+            fclose(f);
+            if ((p = cs_parser_create_chunked(fill_gz_, close_gz_, gz, 0, flags)) == NULL)
+                gzclose(gz);
+            return p;
+        }
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+    else if (got == 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD) {
+#ifdef CS_WITH_ZSTD
+        struct zstd_src_ *z = open_zstd_(f);
+        if (z != NULL) {
+            if ((p = cs_parser_create_chunked(fill_zstd_, close_zstd_, z, 0, flags)) == NULL)
+                close_zstd_(z);
+            return p;
+        }
+#endif
+    }
+    else {
+        if ((p = cs_parser_create_chunked(fill_file_, close_file_, f, 0, flags)) == NULL)
+            fclose(f);
+        return p;
+    }
+
+    // compressed, but without the library to read it
+    fclose(f);
+    return NULL;
+}
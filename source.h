@@ -0,0 +1,95 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_SOURCE_H
+#define CS_SOURCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Block-by-block input (SRC_CHUNKED): a fill function produces the input a block at a time,
+//  e.g. by decompressing it, and the lexer consumes each block in place. Only a bounded
+//  amount of input is ever in memory. With CS_CHUNK_THREADED, blocks are filled ahead of
+//  the lexer by a separate thread.
+
+// writes up to cap bytes of input into buf; returns the number written, 0 at the end of
+//  input, or CS_FILL_ERROR when the input can't be read (the parse fails with ERR_READ)
+typedef size_t (*cs_fill_fn)(void *ctx, char *buf, size_t cap);
+typedef void (*cs_close_fn)(void *ctx);
+// called from another thread while a fill may be blocked, e.g. in read(2): makes it return
+//  soon, and every later one return 0
+typedef void (*cs_cancel_fn)(void *ctx);
+
+#define CS_FILL_ERROR ((size_t)-1)
+
+#define CS_CHUNK_SIZE (256 * 1024)
+#define CS_RA_BLOCK_SIZE (1024 * 1024)
+
+// flags
+#define CS_CHUNK_THREADED 0x01
+
+struct chunk_ring_;
+
+struct cs_chunked {
+    cs_fill_fn fill;
+    cs_close_fn close;
+    cs_cancel_fn cancel;        // NULL unless fill can block indefinitely
+    void *ctx;
+    size_t block_size;
+    char *buffer;               // the only block, unless threaded
+    // the block being lexed: block[len] is always '\0'
+    char *block;
+    size_t len;
+    size_t pos;
+    uint8_t eof;
+    uint8_t failed;             // the input ended with a read error
+    struct chunk_ring_ *ring;   // NULL unless threaded
+};
+
+typedef struct cs_chunked cs_chunked;
+
+// close (may be NULL) is called on ctx when the parser is destroyed; block_size 0 means CS_CHUNK_SIZE.
+//  With CS_CHUNK_THREADED, destroying the parser waits for a fill in progress to return
+cs_json_parser *cs_parser_create_chunked(cs_fill_fn fill, cs_close_fn close, void *ctx, size_t block_size, uint32_t flags);
+
+// read-ahead: a dedicated I/O thread fills a ring of slots blocks (0 for the default of 3,
+//  at least 2) of block_size bytes each (0 for CS_RA_BLOCK_SIZE) ahead of the lexer, so disk
+//  or pipe reads overlap with parsing. Regular files are read with pread, anything else with read,
+//  which destroying the parser interrupts
+cs_json_parser *cs_parser_create_ra(const char *file, size_t block_size, uint32_t slots);
+cs_json_parser *cs_parser_create_rafd(int fd, size_t block_size, uint32_t slots);
+
+// reads a plain, gzip (built with CS_WITH_ZLIB) or zstd (built with CS_WITH_ZSTD) file,
+//  recognised by its magic number, decompressing it block by block
+cs_json_parser *cs_parser_create_z(const char *file, uint32_t flags);
+
+// used by the lexer: moves on to the next block, returns 0 at the end of input
+uint8_t cs_chunked_advance(cs_chunked *s);
+
+void cs_chunked_destroy(cs_chunked *s);
+
+#endif
@@ -3,7 +3,8 @@
 #include "eurysta.h"
 
 // to compile:
-// gcc parser.c c_data_structs/cs_hash_tab.c c_data_structs/cs_linked_list.c object.c -std=c99 test.c -o test -O2
+// gcc parser.c c_data_structs/cs_hash_tab.c c_data_structs/cs_linked_list.c object.c bind.c batch.c pool.c arena.c writer.c source.c cache.c doc.c validate.c project.c patch.c -std=c99 test.c -o test -O2 -lpthread
+// add -DCS_WITH_ZLIB -lz and/or -DCS_WITH_ZSTD -lzstd to read compressed input
 // note: -O3 may result in worse performance because of suboptimal function inlining
 
 int main(int argc, const char **argv) {
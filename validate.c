@@ -0,0 +1,342 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
+#include "eurysta.h"
+
+// SWAR: tests all 8 bytes of a word at once
+#define ONES_  0x0101010101010101ULL
+#define HIGHS_ 0x8080808080808080ULL
+#define HAS_ZERO_(x)    (((x) - ONES_) & ~(x) & HIGHS_)
+#define HAS_BYTE_(x, b) HAS_ZERO_((x) ^ (ONES_ * (b)))
+#define HAS_LESS_(x, n) (((x) - ONES_ * (n)) & ~(x) & HIGHS_)
+
+typedef const unsigned char *ptr_t;
+
+static inline ptr_t ws_(ptr_t p, ptr_t end) {
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+        p++;
+    return p;
+}
+
+static inline uint8_t is_hex_(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// the four hex digits of a \u escape (p points past the 'u'); -1 if they aren't
+static inline int32_t hex4_(ptr_t p, ptr_t end) {
+    if (end - p < 4)
+        return -1;
+    int32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        unsigned char c = p[i];
+        if (!is_hex_(c))
+            return -1;
+        v = (v << 4) | (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+    return v;
+}
+
+// length of the well-formed UTF-8 sequence starting with the (non-ASCII) byte at p, or 0
+static inline uint32_t utf8_(ptr_t p, ptr_t end) {
+    unsigned char c = p[0];
+    uint32_t n;
+    unsigned char lo = 0x80, hi = 0xBF;   // bounds of the second byte
+
+    if (c >= 0xC2 && c <= 0xDF)
+        n = 2;
+    else if (c >= 0xE0 && c <= 0xEF) {
+        n = 3;
+        if (c == 0xE0)
+            lo = 0xA0;  // overlong
+        else if (c == 0xED)
+            hi = 0x9F;  // surrogates
+    }
+    else if (c >= 0xF0 && c <= 0xF4) {
+        n = 4;
+        if (c == 0xF0)
+            lo = 0x90;  // overlong
+        else if (c == 0xF4)
+            hi = 0x8F;  // beyond U+10FFFF
+    }
+    else
+        return 0;
+
+    if ((size_t)(end - p) < n || p[1] < lo || p[1] > hi)
+        return 0;
+    for (uint32_t i = 2; i < n; i++) {
+        if ((p[i] & 0xC0) != 0x80)
+            return 0;
+    }
+    return n;
+}
+
+// the rest of a string, the opening quote consumed; *pp is left past the closing quote,
+//  or on the offending byte
+static err_t string_(ptr_t *pp, ptr_t end, uint32_t flags) {
+    ptr_t p = *pp;
+    const uint8_t utf8 = (flags & CS_VALIDATE_UTF8) != 0;
+
+    for (;;) {
+        // skip 8 plain bytes at a time: no quote, backslash or control character (and
+        //  nothing non-ASCII when that needs checking)
+        while (end - p >= 8) {
+            uint64_t w;
+            memcpy(&w, p, 8);
+            if (HAS_BYTE_(w, '"') | HAS_BYTE_(w, '\\') | HAS_LESS_(w, 0x20) | (utf8 ? w & HIGHS_ : 0))
+                break;
+            p += 8;
+        }
+        if (p >= end) {
+            // unterminated
+            *pp = p;
+            return ERR_ILLEGAL;
+        }
+
+        unsigned char c = *p;
+        if (c == '"') {
+            *pp = p + 1;
+            return ERR_NONE;
+        }
+        if (c < 0x20) {
+            *pp = p;
+            return ERR_ILLEGAL;
+        }
+        if (c >= 0x80 && utf8) {
+            uint32_t n = utf8_(p, end);
+            if (n == 0) {
+                *pp = p;
+                return ERR_ILLEGAL;
+            }
+            p += n;
+            continue;
+        }
+        if (c != '\\') {
+            p++;
+            continue;
+        }
+
+        *pp = p;
+        if (++p >= end)
+            return ERR_INVALID_ESCAPE;
+        switch (*p++) {
+            case '"': case '\\': case '/': case 'b':
+            case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u': {
+                int32_t u = hex4_(p, end);
+                if (u < 0)
+                    return ERR_INVALID_ESCAPE;
+                p += 4;
+                if (!utf8 || u < 0xD800 || u > 0xDFFF)
+                    break;
+                // a high surrogate must be followed by a low one, which can't stand alone
+                if (u >= 0xDC00 || end - p < 6 || p[0] != '\\' || p[1] != 'u')
+                    return ERR_INVALID_ESCAPE;
+                u = hex4_(p + 2, end);
+                if (u < 0xDC00 || u > 0xDFFF)
+                    return ERR_INVALID_ESCAPE;
+                p += 6;
+                break;
+            }
+            default:
+                return ERR_INVALID_ESCAPE;
+        }
+    }
+}
+
+// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?; what follows is up to the caller
+static ptr_t number_(ptr_t p, ptr_t end) {
+    if (p < end && *p == '-')
+        p++;
+    if (p >= end)
+        return NULL;
+    if (*p == '0')
+        p++;
+    else if (*p >= '1' && *p <= '9') {
+        while (p < end && *p >= '0' && *p <= '9')
+            p++;
+    }
+    else
+        return NULL;
+
+    if (p < end && *p == '.') {
+        if (++p >= end || *p < '0' || *p > '9')
+            return NULL;
+        while (p < end && *p >= '0' && *p <= '9')
+            p++;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        if (++p < end && (*p == '+' || *p == '-'))
+            p++;
+        if (p >= end || *p < '0' || *p > '9')
+            return NULL;
+        while (p < end && *p >= '0' && *p <= '9')
+            p++;
+    }
+    return p;
+}
+
+static inline uint8_t literal_(ptr_t p, ptr_t end, const char *s, size_t n) {
+    return (size_t)(end - p) >= n && memcmp(p, s, n) == 0;
+}
+
+err_t cs_json_validate(const char *data, size_t len, uint32_t flags, uint64_t *offset) {
+    const ptr_t start = (ptr_t)data, end = start + len;
+    ptr_t p = start;
+    err_t e = ERR_NONE;
+
+    // one bit per open container: 1 for an object, 0 for an array
+    uint64_t stack[CS_VALIDATE_DEPTH / 64];
+    uint32_t depth = 0;
+
+    // the grammar as a little state machine, with no recursion to exhaust the C stack
+value:
+    p = ws_(p, end);
+    if (p >= end) {
+        e = ERR_EXPECTED_VALUE;
+        goto out;
+    }
+    switch (*p) {
+        case '{': case '[': {
+            uint8_t object = (*p == '{');
+            if (depth == CS_VALIDATE_DEPTH) {
+                e = ERR_ILLEGAL;
+                goto out;
+            }
+            if (object)
+                stack[depth / 64] |= 1ULL << (depth % 64);
+            else
+                stack[depth / 64] &= ~(1ULL << (depth % 64));
+            depth++;
+
+            p = ws_(p + 1, end);
+            if (p < end && *p == (object ? '}' : ']')) {
+                p++;
+                depth--;
+                goto after;
+            }
+            if (object)
+                goto key;
+            goto value;
+        }
+        case '"':
+            p++;
+            if ((e = string_(&p, end, flags)) != ERR_NONE)
+                goto out;
+            goto after;
+        case 't':
+            if (!literal_(p, end, "true", 4)) {
+                e = ERR_EXPECTED_TRUE;
+                goto out;
+            }
+            p += 4;
+            goto after;
+        case 'f':
+            if (!literal_(p, end, "false", 5)) {
+                e = ERR_EXPECTED_FALSE;
+                goto out;
+            }
+            p += 5;
+            goto after;
+        case 'n':
+            if (!literal_(p, end, "null", 4)) {
+                e = ERR_EXPECTED_NULL;
+                goto out;
+            }
+            p += 4;
+            goto after;
+        case '-': case '0': case '1': case '2': case '3':
+        case '4': case '5': case '6': case '7': case '8': case '9': {
+            ptr_t n = number_(p, end);
+            if (n == NULL) {
+                e = ERR_ILLEGAL;
+                goto out;
+            }
+            p = n;
+            goto after;
+        }
+        default:
+            e = ERR_EXPECTED_VALUE;
+            goto out;
+    }
+
+key:
+    // at the first non-whitespace byte
+    if (p >= end || *p != '"') {
+        e = ERR_EXPECTED_KEY;
+        goto out;
+    }
+    p++;
+    if ((e = string_(&p, end, flags)) != ERR_NONE)
+        goto out;
+    p = ws_(p, end);
+    if (p >= end || *p != ':') {
+        e = ERR_EXPECTED_COLON;
+        goto out;
+    }
+    p++;
+    goto value;
+
+after:
+    p = ws_(p, end);
+    if (depth == 0) {
+        // nothing but whitespace may follow the value
+        if (p < end)
+            e = ERR_ILLEGAL;
+        goto out;
+    }
+    if ((stack[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1) {
+        if (p < end && *p == ',') {
+            p = ws_(p + 1, end);
+            goto key;
+        }
+        if (p < end && *p == '}') {
+            p++;
+            depth--;
+            goto after;
+        }
+        e = ERR_EXPECTED_RCURLY;
+    }
+    else {
+        if (p < end && *p == ',') {
+            p++;
+            goto value;
+        }
+        if (p < end && *p == ']') {
+            p++;
+            depth--;
+            goto after;
+        }
+        e = ERR_EXPECTED_RSQUARE;
+    }
+
+out:
+    if (offset != NULL)
+        *offset = (uint64_t)(p - start);
+    return e;
+}
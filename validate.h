@@ -0,0 +1,46 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_VALIDATE_H
+#define CS_VALIDATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// cs_json_validate flags
+#define CS_VALIDATE_UTF8 0x01   // strings must be well-formed UTF-8, \u surrogates paired
+
+// deepest nesting cs_json_validate accepts (its stack is one bit per level)
+#define CS_VALIDATE_DEPTH 65536
+
+// checks that the len bytes at data are exactly one JSON value, optionally surrounded by
+//  whitespace, strictly by RFC 8259 (no leading zeros, no control characters in strings, ...;
+//  the parser itself is more lenient). Nothing is allocated and no NUL terminator is needed.
+// returns ERR_NONE or the first error found, with its byte offset in *offset (if not NULL)
+err_t cs_json_validate(const char *data, size_t len, uint32_t flags, uint64_t *offset);
+
+#endif
@@ -0,0 +1,599 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// fileno and writev are POSIX, not C99
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "eurysta.h"
+
+static void emit_(cs_json_writer *w, const char *s, size_t n) {
+    if (w->error)
+        return;
+    if (w->stream != NULL) {
+        fwrite(s, 1, n, w->stream);
+        return;
+    }
+
+    // keep room for the terminating 0 byte
+    if (w->len + n + 1 > w->cap) {
+        size_t cap = w->cap;
+        while (w->len + n + 1 > cap)
+            cap *= 2;
+        char *b = realloc(w->buffer, cap);
+        if (b == NULL) {
+            w->error = 1;
+            return;
+        }
+        w->buffer = b;
+        w->cap = cap;
+    }
+    memcpy(w->buffer + w->len, s, n);
+    w->len += n;
+    w->buffer[w->len] = '\0';
+}
+
+static inline void emit_char_(cs_json_writer *w, char c) {
+    if (w->stream != NULL && !w->error)
+        putc(c, w->stream);
+    else
+        emit_(w, &c, 1);
+}
+
+// whether the container at level has a member yet; begin_ made room for it
+static inline uint8_t *member_(cs_json_writer *w, uint32_t level) {
+    if (level < CS_WRITER_DEPTH)
+        return &w->has_member[level];
+    return &w->deep[level - CS_WRITER_DEPTH];
+}
+
+// places the separator (if any) in front of the next value or key
+static inline void separate_(cs_json_writer *w) {
+    if (w->after_key) {
+        w->after_key = 0;
+        return;
+    }
+    if (w->depth > 0) {
+        uint8_t *m = member_(w, w->depth - 1);
+        if (*m)
+            emit_char_(w, ',');
+        *m = 1;
+    }
+}
+
+static void escaped_(cs_json_writer *w, const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    emit_char_(w, '"');
+    const char *run = s;
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        // flush the plain run before the character that needs escaping
+        emit_(w, run, s - run);
+        run = s + 1;
+
+        char esc[6] = { '\\', 0 };
+        switch (c) {
+            case '"':  esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            default:
+                esc[1] = 'u'; esc[2] = '0'; esc[3] = '0';
+                esc[4] = hex[c >> 4]; esc[5] = hex[c & 0xF];
+                emit_(w, esc, 6);
+                continue;
+        }
+        emit_(w, esc, 2);
+    }
+    emit_(w, run, s - run);
+    emit_char_(w, '"');
+}
+
+static uint8_t begin_(cs_json_writer *w, char c) {
+    if (w->error)
+        return 0;
+    if (w->depth >= CS_WRITER_DEPTH && w->depth - CS_WRITER_DEPTH >= w->deep_cap) {
+        uint32_t cap = (w->deep_cap > 0) ? w->deep_cap * 2 : CS_WRITER_DEPTH;
+        uint8_t *d = realloc(w->deep, cap);
+        if (d == NULL) {
+            w->error = 1;
+            return 0;
+        }
+        w->deep = d;
+        w->deep_cap = cap;
+    }
+    separate_(w);
+    emit_char_(w, c);
+    *member_(w, w->depth++) = 0;
+    return 1;
+}
+
+static uint8_t end_(cs_json_writer *w, char c) {
+    if (w->depth == 0 || w->after_key) {
+        w->error = 1;
+        return 0;
+    }
+    w->depth--;
+    emit_char_(w, c);
+    return 1;
+}
+
+void cs_writer_init_f(cs_json_writer *w, FILE *f) {
+    w->stream = f;
+    w->buffer = NULL;
+    w->len = w->cap = 0;
+    w->depth = 0;
+    w->after_key = w->error = 0;
+    w->deep = NULL;
+    w->deep_cap = 0;
+}
+
+uint8_t cs_writer_init_b(cs_json_writer *w, size_t hint) {
+    cs_writer_init_f(w, NULL);
+    w->cap = (hint > 0) ? hint + 1 : 256;
+    if ((w->buffer = malloc(w->cap)) == NULL)
+        return 0;
+    w->buffer[0] = '\0';
+    return 1;
+}
+
+const char *cs_writer_get_buf(cs_json_writer *w, size_t *len) {
+    if (len != NULL)
+        *len = w->len;
+    return w->buffer;
+}
+
+void cs_writer_release(cs_json_writer *w) {
+    free(w->buffer);
+    free(w->deep);
+    w->buffer = NULL;
+    w->deep = NULL;
+    w->len = w->cap = 0;
+    w->deep_cap = 0;
+}
+
+uint8_t cs_writer_begin_object(cs_json_writer *w) {
+    return begin_(w, '{');
+}
+
+uint8_t cs_writer_end_object(cs_json_writer *w) {
+    return end_(w, '}');
+}
+
+uint8_t cs_writer_begin_array(cs_json_writer *w) {
+    return begin_(w, '[');
+}
+
+uint8_t cs_writer_end_array(cs_json_writer *w) {
+    return end_(w, ']');
+}
+
+uint8_t cs_writer_key(cs_json_writer *w, const char *key) {
+    if (w->after_key || key == NULL) {
+        w->error = 1;
+        return 0;
+    }
+    separate_(w);
+    escaped_(w, key);
+    emit_char_(w, ':');
+    w->after_key = 1;
+    return 1;
+}
+
+uint8_t cs_writer_string(cs_json_writer *w, const char *s) {
+    separate_(w);
+    escaped_(w, s);
+    return !w->error;
+}
+
+uint8_t cs_writer_number(cs_json_writer *w, double v) {
+    char buf[32];
+    int n = 0;
+    separate_(w);
+    // JSON has no way to spell these
+    if (!isfinite(v)) {
+        emit_(w, "null", 4);
+        return !w->error;
+    }
+    // the shortest of the two that reads back as the same double
+    n = snprintf(buf, sizeof(buf), "%.15g", v);
+    if (strtod(buf, NULL) != v)
+        n = snprintf(buf, sizeof(buf), "%.17g", v);
+    emit_(w, buf, n);
+    return !w->error;
+}
+
+uint8_t cs_writer_bool(cs_json_writer *w, uint8_t v) {
+    separate_(w);
+    if (v)
+        emit_(w, "true", 4);
+    else
+        emit_(w, "false", 5);
+    return !w->error;
+}
+
+uint8_t cs_writer_null(cs_json_writer *w) {
+    separate_(w);
+    emit_(w, "null", 4);
+    return !w->error;
+}
+
+static void write_object_(cs_json_writer *w, cs_json_obj *object) {
+    cs_object_iter it;
+    const char *key;
+    cs_json_obj *val;
+    if (!cs_writer_begin_object(w))
+        return;
+    cs_object_iter_init(&it, object);
+    while (!w->error && cs_object_iter_next(&it, &key, &val)) {
+        cs_writer_key(w, key);
+        cs_writer_value(w, val);
+    }
+    cs_writer_end_object(w);
+}
+
+static void write_array_(cs_json_writer *w, cs_json_obj *array) {
+    cs_array_iter it;
+    cs_json_obj *val;
+    if (!cs_writer_begin_array(w))
+        return;
+    cs_array_iter_init(&it, array);
+    while (!w->error && (val = cs_array_iter_next(&it)) != NULL)
+        cs_writer_value(w, val);
+    cs_writer_end_array(w);
+}
+
+uint8_t cs_writer_raw(cs_json_writer *w, const char *json, size_t len) {
+    separate_(w);
+    emit_(w, json, len);
+    return !w->error;
+}
+
+uint8_t cs_writer_value(cs_json_writer *w, cs_json_obj *obj) {
+    // untouched since it was parsed: the input already holds its serialization, copy it in
+    //  one piece (large spans go past stdio's buffer straight to write(2))
+    if ((obj->flags & (OBJ_FLAG_SPAN | OBJ_FLAG_DIRTY)) == OBJ_FLAG_SPAN) {
+        const struct cs_json_span *s = (const struct cs_json_span *)obj;
+        return cs_writer_raw(w, s->start, s->len);
+    }
+
+    switch (obj->type) {
+        case OBJ_TYPE_STRING:
+            return cs_writer_string(w, (const char *)obj->data);
+        case OBJ_TYPE_NUMBER:
+            // a literal from the input goes back out exactly as it came in
+            if (obj->flags & OBJ_FLAG_RAW) {
+                size_t len = 0;
+                const char *text = cs_number_get_raw(obj, &len);
+                separate_(w);
+                emit_(w, text, len);
+                return !w->error;
+            }
+            return cs_writer_number(w, *(double *)obj->data);
+        case OBJ_TYPE_OBJECT:
+            write_object_(w, obj);
+            break;
+        case OBJ_TYPE_ARRAY:
+            write_array_(w, obj);
+            break;
+        case OBJ_TYPE_NULL:
+            return cs_writer_null(w);
+        case OBJ_TYPE_BOOL:
+            return cs_writer_bool(w, (uintptr_t)obj->data & 1);
+    }
+    return !w->error;
+}
+
+// Parallel writing: a big container is cut into ranges of consecutive members, any thread
+//  encodes a range into a buffer of its own, and the calling thread hands the finished
+//  ranges to the output strictly in order. Encoding may run only so far ahead of the output,
+//  which bounds the memory held in buffers.
+
+// ranges are at least this many members long
+#define PAR_MIN_RANGE 256
+// and there are about this many per thread
+#define PAR_RANGES 64
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+struct par_range_ {
+    union {
+        cs_object_iter object;
+        cs_array_iter array;
+    } it;                   // at the range's first member
+    size_t count;
+    cs_json_writer out;
+    uint8_t done;
+};
+
+struct par_job_ {
+    uint8_t object;
+    uint32_t depth;         // of the container's members
+    struct par_range_ *ranges;
+    size_t count;
+    size_t next;            // first range not claimed yet
+    size_t written;         // ranges handed to the output so far
+    size_t window;          // how many ranges encoding may run ahead of the output
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static void encode_range_(struct par_job_ *job, size_t i) {
+    struct par_range_ *r = &job->ranges[i];
+    cs_json_writer *out = &r->out;
+    if (!cs_writer_init_b(out, 0)) {
+        out->error = 1;
+        return;
+    }
+
+    // pick up inside the container, where the previous range left off
+    out->depth = job->depth;
+    *member_(out, job->depth - 1) = (i > 0);
+    if (job->object) {
+        const char *key;
+        cs_json_obj *val;
+        for (size_t n = 0; n < r->count && cs_object_iter_next(&r->it.object, &key, &val); n++) {
+            cs_writer_key(out, key);
+            cs_writer_value(out, val);
+        }
+    }
+    else {
+        cs_json_obj *val;
+        for (size_t n = 0; n < r->count && (val = cs_array_iter_next(&r->it.array)) != NULL; n++)
+            cs_writer_value(out, val);
+    }
+}
+
+// the next range to encode, if it's within the window; SIZE_MAX if there's none.
+// all of the following are called with the job locked
+static size_t claim_(struct par_job_ *job) {
+    if (job->next < job->count && job->next < job->written + job->window)
+        return job->next++;
+    return SIZE_MAX;
+}
+
+static void encode_claimed_(struct par_job_ *job, size_t i) {
+    pthread_mutex_unlock(&job->lock);
+    encode_range_(job, i);
+    pthread_mutex_lock(&job->lock);
+    job->ranges[i].done = 1;
+    pthread_cond_broadcast(&job->cond);
+}
+
+static void *par_worker_(void *arg) {
+    struct par_job_ *job = arg;
+    pthread_mutex_lock(&job->lock);
+    while (job->next < job->count) {
+        size_t i = claim_(job);
+        if (i != SIZE_MAX)
+            encode_claimed_(job, i);
+        else
+            pthread_cond_wait(&job->cond, &job->lock);
+    }
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+// writes the finished ranges from job->written on, in order; a stream gets them in a single
+//  writev(2) (after whatever stdio still holds)
+static void flush_ranges_(cs_json_writer *w, struct par_job_ *job) {
+    size_t first = job->written, end = first;
+    while (end < job->count && end - first < IOV_MAX && job->ranges[end].done)
+        end++;
+    pthread_mutex_unlock(&job->lock);
+
+    struct iovec iov[IOV_MAX];
+    int n = 0;
+    for (size_t i = first; i < end; i++) {
+        cs_json_writer *out = &job->ranges[i].out;
+        if (out->error)
+            w->error = 1;
+        else if (w->stream == NULL)
+            emit_(w, out->buffer, out->len);
+        else if (out->len > 0)
+            iov[n++] = (struct iovec){ out->buffer, out->len };
+    }
+    if (n > 0 && !w->error) {
+        int fd = fileno(w->stream);
+        fflush(w->stream);
+        for (struct iovec *v = iov; n > 0;) {
+            ssize_t done = writev(fd, v, n);
+            if (done < 0 && errno == EINTR)
+                continue;
+            if (done < 0) {
+                w->error = 1;
+                break;
+            }
+            // a short write: skip what made it out and go again
+            for (; n > 0 && (size_t)done >= v->iov_len; v++, n--)
+                done -= v->iov_len;
+            if (n > 0) {
+                v->iov_base = (char *)v->iov_base + done;
+                v->iov_len -= done;
+            }
+        }
+    }
+    for (size_t i = first; i < end; i++)
+        cs_writer_release(&job->ranges[i].out);
+
+    pthread_mutex_lock(&job->lock);
+    job->written = end;
+    pthread_cond_broadcast(&job->cond);
+}
+
+// writes the n members (or elements) of obj using threads threads; 0 if it couldn't
+//  get started, in which case nothing was written
+static uint8_t par_container_(cs_json_writer *w, cs_json_obj *obj, size_t n, uint32_t threads) {
+    struct par_job_ job = { obj->type == OBJ_TYPE_OBJECT };
+    size_t per = n / ((size_t)threads * PAR_RANGES);
+    if (per < PAR_MIN_RANGE)
+        per = PAR_MIN_RANGE;
+    job.count = (n + per - 1) / per;
+    job.window = (size_t)threads * 2;
+    if ((job.ranges = calloc(job.count, sizeof(*job.ranges))) == NULL)
+        return 0;
+    if (pthread_mutex_init(&job.lock, NULL) != 0) {
+        free(job.ranges);
+        return 0;
+    }
+    if (pthread_cond_init(&job.cond, NULL) != 0) {
+        pthread_mutex_destroy(&job.lock);
+        free(job.ranges);
+        return 0;
+    }
+
+    // one walk over the container places every range's cursor
+    if (job.object) {
+        cs_object_iter it;
+        cs_object_iter_init(&it, obj);
+        for (size_t i = 0; i < job.count; i++) {
+            job.ranges[i].it.object = it;
+            job.ranges[i].count = (n - i * per < per) ? n - i * per : per;
+            for (size_t k = 0; k < job.ranges[i].count; k++)
+                cs_object_iter_next(&it, NULL, NULL);
+        }
+        cs_writer_begin_object(w);
+    }
+    else {
+        cs_array_iter it;
+        cs_array_iter_init(&it, obj);
+        for (size_t i = 0; i < job.count; i++) {
+            job.ranges[i].it.array = it;
+            job.ranges[i].count = (n - i * per < per) ? n - i * per : per;
+            for (size_t k = 0; k < job.ranges[i].count; k++)
+                cs_array_iter_next(&it);
+        }
+        cs_writer_begin_array(w);
+    }
+    job.depth = w->depth;
+
+    // no point in more threads than there are ranges
+    if (threads > job.count)
+        threads = (uint32_t)job.count;
+    pthread_t tids[threads];
+    uint32_t started = 0;
+    // the calling thread works too, so spawn one fewer
+    for (; started < threads - 1; started++) {
+        if (pthread_create(&tids[started], NULL, par_worker_, &job) != 0)
+            break;
+    }
+
+    pthread_mutex_lock(&job.lock);
+    while (job.written < job.count) {
+        size_t i;
+        if (job.ranges[job.written].done)
+            flush_ranges_(w, &job);
+        else if ((i = claim_(&job)) != SIZE_MAX)
+            encode_claimed_(&job, i);
+        else
+            pthread_cond_wait(&job.cond, &job.lock);
+    }
+    pthread_mutex_unlock(&job.lock);
+    for (uint32_t i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.lock);
+    free(job.ranges);
+
+    *member_(w, w->depth - 1) = 1;
+    if (job.object)
+        cs_writer_end_object(w);
+    else
+        cs_writer_end_array(w);
+    return 1;
+}
+
+static void par_value_(cs_json_writer *w, cs_json_obj *obj, uint32_t threads) {
+    size_t n = 0;
+    // a clean span is copied in one piece anyway
+    if ((obj->flags & (OBJ_FLAG_SPAN | OBJ_FLAG_DIRTY)) != OBJ_FLAG_SPAN) {
+        if (obj->type == OBJ_TYPE_OBJECT)
+            n = cs_object_get_size(obj);
+        else if (obj->type == OBJ_TYPE_ARRAY)
+            n = cs_array_get_len(obj);
+    }
+    if (n == 0) {
+        cs_writer_value(w, obj);
+        return;
+    }
+    if (n >= CS_WRITER_PAR_MIN && w->depth < CS_WRITER_DEPTH && par_container_(w, obj, n, threads))
+        return;
+
+    // small, but it may hold something big
+    if (obj->type == OBJ_TYPE_OBJECT) {
+        cs_object_iter it;
+        const char *key;
+        cs_json_obj *val;
+        if (!cs_writer_begin_object(w))
+            return;
+        cs_object_iter_init(&it, obj);
+        while (cs_object_iter_next(&it, &key, &val)) {
+            cs_writer_key(w, key);
+            par_value_(w, val, threads);
+        }
+        cs_writer_end_object(w);
+    }
+    else {
+        cs_array_iter it;
+        cs_json_obj *val;
+        if (!cs_writer_begin_array(w))
+            return;
+        cs_array_iter_init(&it, obj);
+        while ((val = cs_array_iter_next(&it)) != NULL)
+            par_value_(w, val, threads);
+        cs_writer_end_array(w);
+    }
+}
+
+uint8_t cs_writer_value_mt(cs_json_writer *w, cs_json_obj *obj, uint32_t threads) {
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (uint32_t)cpus : 1;
+    }
+    if (threads == 1)
+        return cs_writer_value(w, obj);
+    par_value_(w, obj, threads);
+    return !w->error;
+}
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2011, Coleman Stavish
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+  * Redistributions of source code must retain the above copyright
+	notice, this list of conditions and the following disclaimer.
+  * Redistributions in binary form must reproduce the above copyright
+	notice, this list of conditions and the following disclaimer in the
+	documentation and/or other materials provided with the distribution.
+  * Neither the name of Coleman Stavish nor the
+	names of contributors may be used to endorse or promote products
+	derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COLEMAN STAVISH BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CS_WRITER_H
+#define CS_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Streaming serializer: emits JSON as it is described, so a response can be written
+//  without first materializing a tree. Commas and colons are placed automatically.
+// Output goes either to a FILE * or to a growable memory buffer owned by the writer.
+
+// levels kept inside the writer; deeper ones spill to the heap
+#define CS_WRITER_DEPTH 256
+
+// containers smaller than this are never split up by cs_writer_value_mt
+#define CS_WRITER_PAR_MIN 4096
+
+struct cs_json_writer {
+    FILE *stream;       // NULL when writing to memory
+    char *buffer;
+    size_t len;
+    size_t cap;
+    uint32_t depth;
+    uint8_t after_key;
+    uint8_t error;      // set when out of memory or the calls don't describe valid JSON;
+                        //  nothing more is written after that
+    uint8_t has_member[CS_WRITER_DEPTH];
+    uint8_t *deep;      // has_member for the levels past CS_WRITER_DEPTH
+    uint32_t deep_cap;
+};
+
+typedef struct cs_json_writer cs_json_writer;
+
+void cs_writer_init_f(cs_json_writer *w, FILE *f);
+
+// writes to memory, starting with room for hint bytes
+uint8_t cs_writer_init_b(cs_json_writer *w, size_t hint);
+
+// the NUL-terminated output written to memory so far; it stays owned by the writer
+const char *cs_writer_get_buf(cs_json_writer *w, size_t *len);
+
+// also release a writer to a stream once done: it may have nested past CS_WRITER_DEPTH
+void cs_writer_release(cs_json_writer *w);
+
+uint8_t cs_writer_begin_object(cs_json_writer *w);
+uint8_t cs_writer_end_object(cs_json_writer *w);
+uint8_t cs_writer_begin_array(cs_json_writer *w);
+uint8_t cs_writer_end_array(cs_json_writer *w);
+
+uint8_t cs_writer_key(cs_json_writer *w, const char *key);
+uint8_t cs_writer_string(cs_json_writer *w, const char *s);
+uint8_t cs_writer_number(cs_json_writer *w, double v);
+uint8_t cs_writer_bool(cs_json_writer *w, uint8_t v);
+uint8_t cs_writer_null(cs_json_writer *w);
+
+// writes len bytes of already serialized JSON as the next value, as they are; at the top
+//  level, where nothing separates values, it can also write separators such as newlines
+uint8_t cs_writer_raw(cs_json_writer *w, const char *json, size_t len);
+
+// serializes a whole tree as the next value; subtrees parsed with CS_PARSE_SPANS and not
+//  modified since are copied from the input as they were (whitespace included)
+uint8_t cs_writer_value(cs_json_writer *w, cs_json_obj *obj);
+
+// cs_writer_value, with every container of CS_WRITER_PAR_MIN members or more cut into ranges
+//  that up to threads threads (0: one per online CPU) encode at once. The output is byte for
+//  byte the same; a stream is written with writev(2), after its stdio buffer is flushed.
+// the tree mustn't be modified meanwhile
+uint8_t cs_writer_value_mt(cs_json_writer *w, cs_json_obj *obj, uint32_t threads);
+
+#endif